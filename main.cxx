@@ -1,7 +1,11 @@
 #include <vector>
 #include <string>
+#include <random>
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include "src/main.hxx"
 
 using namespace std;
@@ -9,8 +13,8 @@ using namespace std;
 
 
 
-template <class G, class H>
-void runPagerank(const G& x, const H& xt, int repeat) {
+template <class H>
+void runPagerank(const H& xt, int repeat) {
   vector<float> *init = nullptr;
 
   // Find pagerank using a single thread.
@@ -22,16 +26,187 @@ void runPagerank(const G& x, const H& xt, int repeat) {
   auto a2 = pagerankOmp(xt, init, {repeat});
   auto e2 = absError(a2.ranks, a1.ranks);
   printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankOmp\n", a2.time, a2.iterations, e2);
+
+  // Find pagerank with a fused, edge-balanced OpenMP kernel.
+  auto a3 = pagerankFusedOmp(xt, init, {repeat});
+  auto e3 = absError(a3.ranks, a1.ranks);
+  printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankFusedOmp\n", a3.time, a3.iterations, e3);
+
+  // Find pagerank after relabeling vertices, with pull or partition-centric propagation.
+  for (auto k : {ORDER_NONE, ORDER_DEGREE, ORDER_RCM, ORDER_HUB_CLUSTER}) {
+    for (int B : {0, 65536}) {
+      auto a4 = pagerankBlockedOmp(xt, init, {repeat}, k, B);
+      auto e4 = absError(a4.ranks, a1.ranks);
+      printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankBlockedOmp {order: %s, partition: %d, preprocessing: %.3f ms}\n", a4.time, a4.iterations, e4, vertexOrderName(k), B, a4.preprocessingTime);
+    }
+  }
+
+  // Find pagerank with NUMA-aware placement, and optionally pinned threads.
+  for (auto k : {PIN_NONE, PIN_COMPACT, PIN_SCATTER}) {
+    NumaPlacement pl;
+    auto a6 = pagerankNumaOmp(xt, init, {repeat}, k, &pl);
+    auto e6 = absError(a6.ranks, a1.ranks);
+    printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankNumaOmp {pinning: %s, preprocessing: %.3f ms}\n", a6.time, a6.iterations, e6, threadPinningName(k), a6.preprocessingTime);
+    if (k==PIN_SCATTER) printNumaPlacement(pl);
+  }
+
+  // Find pagerank skipping converged vertices, with synchronous or asynchronous updates.
+  for (bool async : {false, true}) {
+    for (float K : {1e-6f, 1e-5f, 1e-4f}) {
+      PagerankOptions<float> o(repeat);
+      o.skipTolerance = K;
+      o.asynchronous  = async;
+      auto a5 = pagerankAdaptiveOmp(xt, init, o);
+      auto e5 = absError(a5.ranks, a2.ranks);
+      size_t nv = sum(a5.verticesProcessed), ne = sum(a5.edgesProcessed);
+      printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankAdaptiveOmp {schedule: %s, skip: %.0e, vertices: %zu, edges: %zu, work: %.1f%%}\n", a5.time, a5.iterations, e5, async? "asynchronous" : "synchronous", K, nv, ne, 100.0*ne/(double(xt.size())*(a2.iterations+1)));
+    }
+  }
+}
+
+
+template <class H>
+void runPagerankBatch(const H& xt, int repeat) {
+  using Results = vector<PagerankResult<float>>;
+  mt19937 rnd(42);
+  int Q = 64, N = xt.order();
+  auto ks = vertices(xt);
+  vector<vector<int>> seeds(Q);
+  for (auto& ss : seeds) {
+    for (int i=0; i<4; i++)
+      ss.push_back(ks[rnd() % ks.size()]);
+  }
+  auto iters = [](const Results& as) { int l = 0; for (auto& a : as) l = max(l, a.iterations); return l; };
+
+  // Find personalized pagerank of each seed set, one query at a time.
+  Results a1, a2;
+  float t1 = measureDuration([&]() { a1 = pagerankBatchOmp(xt, seeds, PagerankOptions<float>(), 1); }, repeat);
+  printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankBatchOmp {queries: %d, chunk: 1}\n", t1, iters(a1), 0.0f, Q);
+
+  // Find personalized pagerank of all seed sets together.
+  float t2 = measureDuration([&]() { a2 = pagerankBatchOmp(xt, seeds); }, repeat);
+  float e2 = 0;
+  for (int q=0; q<Q; q++)
+    e2 = max(e2, absError(a2[q].ranks, a1[q].ranks));
+  printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankBatchOmp {queries: %d, chunk: %d}\n", t2, iters(a2), e2, Q, int(min(size_t(Q), PAGERANK_BATCH_BUDGET / (3*sizeof(float)*max(N, 1)))));
+}
+
+
+template <class G, class H>
+void runPagerankDynamic(G& x, H& xt, int repeat) {
+  vector<float> *init = nullptr;
+  mt19937 rnd(42);
+  int B = max(1, x.size()/2000);
+
+  // Find pagerank of the graph, before the update.
+  auto a0 = pagerankOmp(xt, init, {1});
+  auto deletions  = randomDeletions(x, B, rnd);
+  auto insertions = randomInsertions(x, B, rnd);
+  updateBatch(x, xt, deletions, insertions);
+
+  // Find pagerank of the updated graph, from scratch.
+  auto a1 = pagerankOmp(xt, init, {repeat});
+  printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankStaticOmp\n", a1.time, a1.iterations, 0.0f);
+
+  // Find pagerank of the updated graph, from previous ranks.
+  auto a2 = pagerankDynamicOmp(x, xt, deletions, insertions, a0.ranks, {repeat});
+  auto e2 = absError(a2.ranks, a1.ranks);
+  printf("[%09.3f ms; %03d iters.] [%.4e err.] pagerankDynamicOmp\n", a2.time, a2.iterations, e2);
+}
+
+
+// Parse a comma-separated list of integers.
+vector<int> parseInts(const string& x) {
+  vector<int> a; stringstream s(x); string t;
+  while (getline(s, t, ','))
+    if (!t.empty()) a.push_back(stoi(t));
+  return a;
+}
+
+vector<string> parseNames(const string& x) {
+  vector<string> a; stringstream s(x); string t;
+  while (getline(s, t, ','))
+    if (!t.empty()) a.push_back(t);
+  return a;
+}
+
+
+// Run engines on graphs in one process, for each thread count.
+// Usage: a.out --benchmark [--threads 1,2,4] [--repeat 5] [--warmup 1] [--engines pagerankSeq,pagerankOmp] [--perf] [--digraph] [--json out.json] [--csv out.csv] graph.mtx ...
+int benchmarkMain(int argc, char **argv) {
+  using G = BenchmarkGraph;
+  vector<pair<string, BenchmarkEngine>> all = {
+    {"pagerankSeq",         [](const G& xt) { return pagerankSeq(xt, (vector<float>*) nullptr); }},
+    {"pagerankOmp",         [](const G& xt) { return pagerankOmp(xt, (vector<float>*) nullptr); }},
+    {"pagerankFusedOmp",    [](const G& xt) { return pagerankFusedOmp(xt, (vector<float>*) nullptr); }},
+    {"pagerankBlockedOmp",  [](const G& xt) { return pagerankBlockedOmp(xt, (vector<float>*) nullptr, {}, ORDER_DEGREE); }},
+    {"pagerankAdaptiveOmp", [](const G& xt) { return pagerankAdaptiveOmp(xt, (vector<float>*) nullptr); }},
+    {"pagerankNumaOmp",     [](const G& xt) { return pagerankNumaOmp(xt, (vector<float>*) nullptr, {}, PIN_COMPACT); }}
+  };
+  BenchmarkOptions o;
+  vector<pair<string, BenchmarkEngine>> engines;
+  vector<char*> graphs;
+  vector<string> names;
+  string json, csv;
+  for (int i=2; i<argc; i++) {
+    string a = argv[i];
+    if      (a=="--threads" && i+1<argc) o.threads = parseInts(argv[++i]);
+    else if (a=="--repeat"  && i+1<argc) o.repeat  = stoi(argv[++i]);
+    else if (a=="--warmup"  && i+1<argc) o.warmup  = stoi(argv[++i]);
+    else if (a=="--engines" && i+1<argc) names = parseNames(argv[++i]);
+    else if (a=="--json"    && i+1<argc) json = argv[++i];
+    else if (a=="--csv"     && i+1<argc) csv  = argv[++i];
+    else if (a=="--perf") o.perf = true;
+    else if (a=="--digraph") o.digraph = true;
+    else graphs.push_back(argv[i]);
+  }
+  if (o.threads.empty()) o.threads.push_back(omp_get_max_threads());
+  if (names.empty()) engines = all;
+  for (auto& name : names) {
+    auto it = find_if(all.begin(), all.end(), [&](const auto& e) { return e.first==name; });
+    if (it==all.end()) { fprintf(stderr, "unknown engine: %s\n", name.c_str()); return 1; }
+    engines.push_back(*it);
+  }
+  vector<BenchmarkRecord> rs;
+  for (char *pth : graphs)
+    runBenchmark(rs, pth, engines, o);
+  if (!json.empty()) { ofstream f(json); writeBenchmarkJson(f, rs); }
+  if (!csv.empty())  { ofstream f(csv);  writeBenchmarkCsv(f, rs); }
+  if (json.empty() && csv.empty()) writeBenchmarkJson(cout, rs);
+  return 0;
 }
 
 
+// Usage: a.out graph.mtx [repeat] [snapshot] [--dynamic] [--no-verify]
 int main(int argc, char **argv) {
-  char *file = argv[1];
-  int repeat = argc>2? stoi(argv[2]) : 5;
+  if (argc>1 && string(argv[1])=="--benchmark") return benchmarkMain(argc, argv);
+  vector<char*> args; bool dynamic = false, verify = true;
+  for (int i=1; i<argc; i++) {
+    if      (string(argv[i])=="--dynamic")   dynamic = true;
+    else if (string(argv[i])=="--no-verify") verify  = false;
+    else args.push_back(argv[i]);
+  }
+  char *file = args[0];
+  int repeat = args.size()>1? stoi(args[1]) : 5;
+  char *snap = args.size()>2? args[2] : nullptr;
   printf("Loading graph %s ...\n", file);
-  auto x  = readMtx(file); println(x);
-  auto xt = transposeWithDegree(x); print(xt); printf(" (transposeWithDegree)\n");
-  runPagerank(x, xt, repeat);
+  if (snap) {
+    auto xt = readSnapshotOrMtx(file, snap, verify); print(xt); printf(" (snapshot)\n");
+    runPagerank(xt, repeat);
+    runPagerankBatch(xt, repeat);
+  }
+  else {
+    auto x  = readMtxCsr(file); println(x);
+    auto xt = transposeWithDegree(x); print(xt); printf(" (transposeWithDegree)\n");
+    runPagerank(xt, repeat);
+    runPagerankBatch(xt, repeat);
+  }
+  // dynamic graphs need the (slower to build) mutable graph, so run only on request
+  if (dynamic) {
+    auto x  = readMtx(file);
+    auto xt = transposeWithDegree(x); print(xt); printf(" (dynamic, batch=%d)\n", 2*max(1, x.size()/2000));
+    runPagerankDynamic(x, xt, repeat);
+  }
   printf("\n");
   return 0;
 }
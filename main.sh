@@ -10,37 +10,28 @@ git clone https://github.com/puzzlef/$src
 cd $src
 
 # Run
-run() {
-g++ -O3 -fopenmp main.cxx
-echo "OMP_NUM_THREADS=$OMP_NUM_THREADS"                     | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/min-1DeadEnd.mtx      2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/min-2SCC.mtx          2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/min-4SCC.mtx          2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/min-NvgraphEx.mtx     2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/web-Stanford.mtx      2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/web-BerkStan.mtx      2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/web-Google.mtx        2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/web-NotreDame.mtx     2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/soc-Slashdot0811.mtx  2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/soc-Slashdot0902.mtx  2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/soc-Epinions1.mtx     2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/coAuthorsDBLP.mtx     2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/coAuthorsCiteseer.mtx 2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/soc-LiveJournal1.mtx  2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/coPapersCiteseer.mtx  2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/coPapersDBLP.mtx      2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/indochina-2004.mtx    2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/italy_osm.mtx         2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/great-britain_osm.mtx 2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/germany_osm.mtx       2>&1 | tee -a "$out"
-stdbuf --output=L ./a.out ~/data/asia_osm.mtx          2>&1 | tee -a "$out"
-echo ""                                                     | tee -a "$out"
-}
-
-export OMP_NUM_THREADS=2  && run
-export OMP_NUM_THREADS=4  && run
-export OMP_NUM_THREADS=8  && run
-export OMP_NUM_THREADS=16 && run
-export OMP_NUM_THREADS=28 && run
-export OMP_NUM_THREADS=32 && run
-export OMP_NUM_THREADS=48 && run
+g++ -O3 -march=native -fopenmp main.cxx
+stdbuf --output=L ./a.out --benchmark \
+  --threads 2,4,8,16,28,32,48 --repeat 5 --warmup 1 --perf \
+  --json "${out%.log}.json" --csv "${out%.log}.csv" \
+  ~/data/min-1DeadEnd.mtx \
+  ~/data/min-2SCC.mtx \
+  ~/data/min-4SCC.mtx \
+  ~/data/min-NvgraphEx.mtx \
+  ~/data/web-Stanford.mtx \
+  ~/data/web-BerkStan.mtx \
+  ~/data/web-Google.mtx \
+  ~/data/web-NotreDame.mtx \
+  ~/data/soc-Slashdot0811.mtx \
+  ~/data/soc-Slashdot0902.mtx \
+  ~/data/soc-Epinions1.mtx \
+  ~/data/coAuthorsDBLP.mtx \
+  ~/data/coAuthorsCiteseer.mtx \
+  ~/data/soc-LiveJournal1.mtx \
+  ~/data/coPapersCiteseer.mtx \
+  ~/data/coPapersDBLP.mtx \
+  ~/data/indochina-2004.mtx \
+  ~/data/italy_osm.mtx \
+  ~/data/great-britain_osm.mtx \
+  ~/data/germany_osm.mtx \
+  ~/data/asia_osm.mtx 2>&1 | tee -a "$out"
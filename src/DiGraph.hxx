@@ -70,6 +70,13 @@ class DiGraph {
     M++;
   }
 
+  // Caller ensures u, v exist and u->v is not already present.
+  void addEdgeUnchecked(int u, int v, E d=E()) {
+    vto[u].push_back(v);
+    edata[u].push_back(d);
+    M++;
+  }
+
   void removeEdge(int u, int v) {
     if (!hasEdge(u, v)) return;
     int o = ei(u, v);
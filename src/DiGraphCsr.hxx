@@ -0,0 +1,147 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include "_main.hxx"
+#include "vertices.hxx"
+
+using std::vector;
+using std::move;
+
+
+
+
+// Read-only directed graph in CSR format.
+// Vertices are stored by index (in increasing order of id), and edges
+// refer to target indices; the interface however accepts and yields ids.
+template <class V=NONE, class E=NONE>
+class DiGraphCsr {
+  public:
+  using TVertex = V;
+  using TEdge   = E;
+
+  private:
+  vector<int> vkeys;  // id of each vertex index
+  vector<int> vidx;   // index of each vertex id (-1 if none)
+  vector<int> vfrom;  // edge offsets of each vertex index
+  vector<int> eto;    // target vertex index of each edge
+  vector<V>   vdata;
+  vector<E>   edata;
+
+  // Cute helpers
+  private:
+  int s() const { return vidx.size(); }
+  int ei(int u, int v) const {
+    int i = vidx[u], j = vidx[v];
+    for (int k=vfrom[i]; k<vfrom[i+1]; k++)
+      if (eto[k]==j) return k;
+    return -1;
+  }
+
+  // Read operations
+  public:
+  int span()  const { return s(); }
+  int order() const { return vkeys.size(); }
+  int size()  const { return eto.size(); }
+
+  bool hasVertex(int u)      const { return u >= 0 && u < s() && vidx[u] >= 0; }
+  bool hasEdge(int u, int v) const { return hasVertex(u) && hasVertex(v) && ei(u, v) >= 0; }
+  auto edges(int u) const {
+    int i = hasVertex(u)? vidx[u] : -1;
+    int b = i<0? 0 : vfrom[i], e = i<0? 0 : vfrom[i+1];
+    return transform(slice(eto, b, e), [this](int j) { return vkeys[j]; });
+  }
+  int degree(int u)    const { return hasVertex(u)? vfrom[vidx[u]+1] - vfrom[vidx[u]] : 0; }
+  auto vertices()      const { return iterable(vkeys); }
+  auto nonVertices()   const { return filter(range(s()), [&](int u) { return !hasVertex(u); }); }
+  auto inEdges(int v)  const { return filter(vertices(), [this, v](int u) { return hasEdge(u, v); }); }
+  int inDegree(int v) const { return countIf(vertices(), [this, v](int u) { return hasEdge(u, v); }); }
+
+  V vertexData(int u)      const { return hasVertex(u)? vdata[vidx[u]] : V(); }
+  E edgeData(int u, int v) const { return hasEdge(u, v)? edata[ei(u, v)] : E(); }
+
+  // CSR arrays
+  public:
+  const vector<int>& vertexKeys()         const { return vkeys; }
+  const vector<int>& vertexIndices()      const { return vidx; }
+  const vector<int>& sourceOffsets()      const { return vfrom; }
+  const vector<int>& destinationIndices() const { return eto; }
+  const vector<V>&   vertexValues()       const { return vdata; }
+  const vector<E>&   edgeValues()         const { return edata; }
+
+  // Generate operations
+  public:
+  template <class T>
+  auto vertexContainer(T _) const { return vector<T>(s()); }
+
+  // Constructors
+  public:
+  DiGraphCsr() : vfrom(1) {}
+
+  DiGraphCsr(vector<int>&& vkeys, vector<int>&& vidx, vector<int>&& vfrom, vector<int>&& eto, vector<V>&& vdata, vector<E>&& edata) :
+  vkeys(move(vkeys)), vidx(move(vidx)), vfrom(move(vfrom)), eto(move(eto)), vdata(move(vdata)), edata(move(edata)) {}
+};
+
+
+
+
+// VERTEX-INDICES
+// --------------
+// Index of each vertex id in a vertex key list (-1 if none).
+
+inline vector<int> vertexIndicesOmp(const vector<int>& vkeys, int S) {
+  int N = vkeys.size();
+  vector<int> a(S);
+  fillOmp(a, -1);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<N; i++)
+    a[vkeys[i]] = i;
+  return a;
+}
+
+
+
+
+// CSR-GRAPH
+// ---------
+
+template <class G>
+auto csrGraph(const G& x) {
+  using V = typename G::TVertex;
+  using E = typename G::TEdge;
+  auto vkeys = vertices(x);
+  auto vidx  = vertexIndicesOmp(vkeys, x.span());
+  auto vfrom = sourceOffsets(x, vkeys);
+  auto vdata = vertexData(x, vkeys);
+  vector<int> eto; vector<E> edata;
+  eto.reserve(x.size());
+  edata.reserve(x.size());
+  for (int u : vkeys) {
+    for (int v : x.edges(u)) {
+      eto.push_back(vidx[v]);
+      edata.push_back(x.edgeData(u, v));
+    }
+  }
+  return DiGraphCsr<V, E>(move(vkeys), move(vidx), move(vfrom), move(eto), move(vdata), move(edata));
+}
+
+
+
+
+// CSR-ARRAYS
+// ----------
+// Borrow CSR arrays directly, instead of extracting a copy.
+
+template <class V, class E>
+const vector<int>& sourceOffsets(const DiGraphCsr<V, E>& x) {
+  return x.sourceOffsets();
+}
+
+template <class V, class E>
+const vector<int>& destinationIndices(const DiGraphCsr<V, E>& x) {
+  return x.destinationIndices();
+}
+
+template <class V, class E>
+const vector<V>& vertexData(const DiGraphCsr<V, E>& x) {
+  return x.vertexValues();
+}
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include "_cmath.h"
 
 using std::vector;
 using std::find;
@@ -9,6 +10,7 @@ using std::count;
 using std::count_if;
 using std::copy;
 using std::abs;
+using std::min;
 
 
 
@@ -78,13 +80,17 @@ void copy(vector<T>& a, const vector<T>& x) {
 
 
 template <class T>
-void copyOmp(vector<T>& a, const vector<T>& x) {
-  int N = x.size();
+void copyOmp(T *a, const T *x, int N) {
   #pragma omp parallel for schedule(static,4096)
   for (int i=0; i<N; i++)
     a[i] = x[i];
 }
 
+template <class T, class A, class B>
+void copyOmp(vector<T, A>& a, const vector<T, B>& x) {
+  copyOmp(a.data(), x.data(), x.size());
+}
+
 
 
 
@@ -104,15 +110,15 @@ void fill(vector<T>& a, const T& v) {
 
 
 template <class T>
-void fillOmp(T *a, int N, const T& v) {
+void fillOmp(T *a, size_t N, const T& v) {
   #pragma omp parallel for schedule(static,4096)
-  for (int i=0; i<N; i++)
+  for (size_t i=0; i<N; i++)
     a[i] = v;
 }
 
-template <class T>
-void fillOmp(vector<T>& a, const T& v) {
-  fillOmp(a.data(), (int) a.size(), v);
+template <class T, class A>
+void fillOmp(vector<T, A>& a, const T& v) {
+  fillOmp(a.data(), a.size(), v);
 }
 
 
@@ -165,12 +171,33 @@ auto sumAt(const T *x, I&& is) {
   return a;
 }
 
-template <class T, class I>
-auto sumAt(const vector<T>& x, I&& is) {
+template <class T, class A, class I>
+auto sumAt(const vector<T, A>& x, I&& is) {
   return sumAt(x.data(), is);
 }
 
 
+template <class T>
+auto sumAt(const T *x, const int *is, int N) {
+  T a = T();
+  for (int i=0; i<N; i++)
+    a += x[is[i]];
+  return a;
+}
+
+
+// Gather-sum with explicit vectorization (needs -fopenmp). Vector gathers need
+// AVX2 (-mavx2, or -march=native); without it, this is a plain scalar loop.
+template <class T>
+auto sumAtSimd(const T *x, const int *is, int N) {
+  T a = T();
+  #pragma omp simd reduction(+:a)
+  for (int i=0; i<N; i++)
+    a += x[is[i]];
+  return a;
+}
+
+
 
 
 // ADD-VALUE
@@ -233,8 +260,8 @@ auto absErrorOmp(const T *x, const T *y, int N) {
   return a;
 }
 
-template <class T>
-auto absErrorOmp(const vector<T>& x, const vector<T>& y) {
+template <class T, class A, class B>
+auto absErrorOmp(const vector<T, A>& x, const vector<T, B>& y) {
   return absErrorOmp(x.data(), y.data(), x.size());
 }
 
@@ -263,7 +290,55 @@ void multiplyOmp(T *a, const T *x, const T *y, int N) {
     a[i] = x[i] * y[i];
 }
 
-template <class T>
-void multiplyOmp(vector<T>& a, const vector<T>& x, const vector<T>& y) {
+template <class T, class A>
+void multiplyOmp(vector<T, A>& a, const vector<T, A>& x, const vector<T, A>& y) {
   multiplyOmp(a.data(), x.data(), y.data(), x.size());
 }
+
+
+
+
+// EXCLUSIVE-SCAN
+// --------------
+
+template <class T>
+auto exclusiveScan(T *a, const T *x, int N) {
+  T s = T();
+  for (int i=0; i<N; i++) {
+    T v = x[i];
+    a[i] = s;
+    s += v;
+  }
+  return s;
+}
+
+template <class T>
+auto exclusiveScan(vector<T>& a, const vector<T>& x) {
+  return exclusiveScan(a.data(), x.data(), x.size());
+}
+
+
+template <class T>
+auto exclusiveScanOmp(T *a, const T *x, int N) {
+  const int B = 65536;
+  int  NB = ceilDiv(N, B);
+  if (NB<=1) return exclusiveScan(a, x, N);
+  vector<T> bs(NB);
+  #pragma omp parallel for schedule(static)
+  for (int b=0; b<NB; b++) {
+    int i = b*B, I = min(i+B, N);
+    bs[b] = exclusiveScan(a+i, x+i, I-i);
+  }
+  T s = exclusiveScan(bs.data(), bs.data(), NB);
+  #pragma omp parallel for schedule(static)
+  for (int b=0; b<NB; b++) {
+    int i = b*B, I = min(i+B, N);
+    addValue(a+i, I-i, bs[b]);
+  }
+  return s;
+}
+
+template <class T>
+auto exclusiveScanOmp(vector<T>& a, const vector<T>& x) {
+  return exclusiveScanOmp(a.data(), x.data(), x.size());
+}
@@ -2,6 +2,7 @@
 #include <chrono>
 
 using std::chrono::microseconds;
+using std::chrono::nanoseconds;
 using std::chrono::high_resolution_clock;
 using std::chrono::duration_cast;
 
@@ -20,3 +21,16 @@ float measureDuration(F fn, int N=1) {
   auto duration = duration_cast<microseconds>(stop - start);
   return duration.count()/(N*1000.0f);
 }
+
+
+
+// Time taken (ms) between two time points.
+template <class T>
+float duration(const T& start, const T& stop) {
+  auto duration = duration_cast<nanoseconds>(stop - start);
+  return duration.count()/1000000.0f;
+}
+
+inline auto timeNow() {
+  return high_resolution_clock::now();
+}
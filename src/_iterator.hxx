@@ -2,6 +2,7 @@
 #include <iterator>
 #include <algorithm>
 
+using std::iterator_traits;
 using std::forward_iterator_tag;
 using std::random_access_iterator_tag;
 using std::distance;
@@ -23,15 +24,15 @@ using std::max;
   using pointer    = ptr;
 
 #define ITERATOR_USING_I(I) \
-  using iterator_category = typename I::iterator_category; \
-  using difference_type   = typename I::difference_type; \
-  using value_type = typename I::value_type; \
-  using reference  = typename I::reference; \
-  using pointer    = typename I::pointer;
+  using iterator_category = typename iterator_traits<I>::iterator_category; \
+  using difference_type   = typename iterator_traits<I>::difference_type; \
+  using value_type = typename iterator_traits<I>::value_type; \
+  using reference  = typename iterator_traits<I>::reference; \
+  using pointer    = typename iterator_traits<I>::pointer;
 
 #define ITERATOR_USING_IVR(I, val, ref) \
-  using iterator_category = typename I::iterator_category; \
-  using difference_type   = typename I::difference_type; \
+  using iterator_category = typename iterator_traits<I>::iterator_category; \
+  using difference_type   = typename iterator_traits<I>::difference_type; \
   using value_type = val; \
   using reference  = ref; \
   using pointer    = value_type*;
@@ -5,3 +5,5 @@
 #include "_ctypes.hxx"
 #include "_iostream.hxx"
 #include "_iterator.hxx"
+#include "_memory.hxx"
+#include "_span.hxx"
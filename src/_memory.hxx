@@ -0,0 +1,43 @@
+#pragma once
+#include <new>
+#include <memory>
+#include <vector>
+#include <utility>
+
+using std::vector;
+using std::allocator;
+using std::allocator_traits;
+using std::forward;
+
+
+
+
+// DEFAULT-INIT-ALLOCATOR
+// ----------------------
+// Allocator that default-initializes (instead of value-initializing) on
+// resize, so that pages are not touched until first written.
+
+template <class T, class A=allocator<T>>
+class DefaultInitAllocator : public A {
+  using traits = allocator_traits<A>;
+
+  public:
+  template <class U>
+  struct rebind { using other = DefaultInitAllocator<U, typename traits::template rebind_alloc<U>>; };
+
+  using A::A;
+
+  template <class U>
+  void construct(U *p) noexcept(noexcept(::new((void*) p) U)) {
+    ::new((void*) p) U;
+  }
+
+  template <class U, class... Args>
+  void construct(U *p, Args&&... args) {
+    traits::construct(static_cast<A&>(*this), p, forward<Args>(args)...);
+  }
+};
+
+
+template <class T>
+using DefaultInitVector = vector<T, DefaultInitAllocator<T>>;
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+
+
+
+// SPAN
+// ----
+// Non-owning view of a contiguous array.
+
+template <class T>
+class Span {
+  T     *ptr;
+  size_t N;
+
+  public:
+  Span() : ptr(nullptr), N(0) {}
+  Span(T *ptr, size_t N) : ptr(ptr), N(N) {}
+  T* data()  const { return ptr; }
+  T* begin() const { return ptr; }
+  T* end()   const { return ptr+N; }
+  size_t size() const { return N; }
+  bool  empty() const { return N == 0; }
+  T& operator[](size_t i) const { return ptr[i]; }
+};
+
+
+template <class T>
+auto span(T *x, size_t N) {
+  return Span<T>(x, N);
+}
@@ -0,0 +1,314 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <algorithm>
+#include <functional>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include "_main.hxx"
+#include "DiGraph.hxx"
+#include "DiGraphCsr.hxx"
+#include "transpose.hxx"
+#include "mtx.hxx"
+#include "pagerank.hxx"
+
+using std::string;
+using std::vector;
+using std::pair;
+using std::move;
+using std::ostream;
+using std::function;
+using std::sort;
+using std::min;
+using std::max;
+using std::to_string;
+
+
+
+
+// BENCHMARK-SUMMARY
+// -----------------
+
+struct BenchmarkSummary {
+  float min, median, p95;
+};
+
+// Min, median, and 95th percentile (nearest rank) of samples.
+inline BenchmarkSummary benchmarkSummary(vector<float> xs) {
+  int N = xs.size();
+  if (N==0) return {0, 0, 0};
+  sort(xs.begin(), xs.end());
+  float med = N%2? xs[N/2] : (xs[N/2-1] + xs[N/2])/2;
+  int   i95 = min(N-1, max(0, int(ceilDiv(95*N, 100))-1));
+  return {xs[0], med, xs[i95]};
+}
+
+
+
+
+// PERF-COUNTERS
+// -------------
+// Hardware counters of all OpenMP threads, with perf_event_open. Counters
+// are opened by each thread of the current team, so reopen them after the
+// number of threads changes. Unavailable counters (no permission, or no
+// PMU in a VM) leave the set closed.
+
+#define PERF_COUNTERS 3
+
+inline const char* perfCounterName(int i) {
+  static const char *names[] = {"instructions", "cycles", "cache-misses"};
+  return names[i];
+}
+
+inline int perfEventOpen(uint64_t config) {
+  struct perf_event_attr pe;
+  memset(&pe, 0, sizeof(pe));
+  pe.type   = PERF_TYPE_HARDWARE;
+  pe.size   = sizeof(pe);
+  pe.config = config;
+  pe.disabled = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv     = 1;
+  return syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+
+class PerfCounters {
+  vector<int> fds;  // PERF_COUNTERS per thread
+  bool ok = false;
+
+  void ioctlAll(unsigned long req) {
+    for (int fd : fds)
+      ioctl(fd, req, 0);
+  }
+
+  public:
+  bool enabled() const { return ok; }
+
+  bool open() {
+    const uint64_t cs[PERF_COUNTERS] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES};
+    close();
+    ok = true;
+    #pragma omp parallel
+    {
+      int fs[PERF_COUNTERS];
+      for (int i=0; i<PERF_COUNTERS; i++)
+        fs[i] = perfEventOpen(cs[i]);
+      #pragma omp critical
+      {
+        for (int i=0; i<PERF_COUNTERS; i++) {
+          if (fs[i]<0) ok = false;
+          else fds.push_back(fs[i]);
+        }
+      }
+    }
+    if (!ok) close();
+    return ok;
+  }
+
+  void close() {
+    for (int fd : fds)
+      ::close(fd);
+    fds.clear();
+    ok = false;
+  }
+
+  void start() { ioctlAll(PERF_EVENT_IOC_RESET); ioctlAll(PERF_EVENT_IOC_ENABLE); }
+  void stop()  { ioctlAll(PERF_EVENT_IOC_DISABLE); }
+
+  // Sum of each counter, over all threads.
+  void read(double *a) {
+    for (int i=0; i<PERF_COUNTERS; i++)
+      a[i] = 0;
+    for (size_t j=0; j<fds.size(); j++) {
+      uint64_t x = 0;
+      if (::read(fds[j], &x, sizeof(x))==sizeof(x)) a[j % PERF_COUNTERS] += x;
+    }
+  }
+
+  PerfCounters() {}
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters() { close(); }
+};
+
+
+
+
+// BENCHMARK-RECORD
+// ----------------
+// Timing samples (ms) of one phase, for a graph, engine, and thread count.
+// Graph phases (load, transpose, and csr if loaded via DiGraph) have no engine. Engine phases are
+// initialization, iteration.<i>, and total; the total carries iterations,
+// error (relative to the first engine), and counters (average per run).
+
+struct BenchmarkRecord {
+  string graph;
+  int    threads;
+  string engine;
+  string phase;
+  int    iterations = 0;
+  float  error = 0;
+  vector<float>  samples;
+  vector<double> counters;
+};
+
+
+struct BenchmarkOptions {
+  vector<int> threads;
+  int  repeat = 5;
+  int  warmup = 1;
+  bool perf   = false;
+  bool digraph = false;  // load via DiGraph (slow, serial), instead of CSR
+};
+
+
+using BenchmarkGraph  = DiGraphCsr<int, NONE>;
+using BenchmarkEngine = function<PagerankResult<float>(const BenchmarkGraph&)>;
+
+
+// Name of a graph file, without directory or extension.
+inline string benchmarkGraphName(const char *pth) {
+  string a = pth;
+  size_t i = a.find_last_of('/');
+  if (i!=string::npos) a = a.substr(i+1);
+  size_t j = a.rfind('.');
+  return j==string::npos? a : a.substr(0, j);
+}
+
+
+
+
+// RUN-BENCHMARK
+// -------------
+
+// Load graph (as CSR), and transpose with degree, timing each phase.
+// The transpose is already in CSR, so there is no csr phase.
+inline BenchmarkGraph benchmarkLoad(vector<float>& tl, vector<float>& tt, const char *pth) {
+  DiGraphCsr<> x; BenchmarkGraph xt;
+  tl.push_back(measureDuration([&]() { x  = readMtxCsr(pth); }));
+  tt.push_back(measureDuration([&]() { xt = transposeWithDegree(x); }));
+  return xt;
+}
+
+// Load graph (as DiGraph), transpose with degree, and extract CSR, timing each phase.
+inline BenchmarkGraph benchmarkLoadDiGraph(vector<float>& tl, vector<float>& tt, vector<float>& tc, const char *pth) {
+  DiGraph<> x; DiGraph<int> xt;
+  tl.push_back(measureDuration([&]() { x  = readMtx(pth); }));
+  tt.push_back(measureDuration([&]() { xt = transposeWithDegree(x); }));
+  BenchmarkGraph a;
+  tc.push_back(measureDuration([&]() { a = csrGraph(xt); }));
+  return a;
+}
+
+
+// Run engines on a graph, for each thread count.
+// @param a (output) records of each phase
+// @param pth path to mtx file
+// @param engines named engines to run (first one is the reference for error)
+// @param o options {threads, repeat, warmup, perf, digraph}
+inline void runBenchmark(vector<BenchmarkRecord>& a, const char *pth, const vector<pair<string, BenchmarkEngine>>& engines, const BenchmarkOptions& o) {
+  string graph = benchmarkGraphName(pth);
+  for (int T : o.threads) {
+    omp_set_num_threads(T);
+    // load phases
+    vector<float> tl, tt, tc;
+    BenchmarkGraph xt;
+    for (int i=0; i<o.warmup+o.repeat; i++) {
+      vector<float> dl, dt, dc;
+      auto& al = i<o.warmup? dl : tl, &at = i<o.warmup? dt : tt, &ac = i<o.warmup? dc : tc;
+      xt = o.digraph? benchmarkLoadDiGraph(al, at, ac, pth) : benchmarkLoad(al, at, pth);
+    }
+    a.push_back({graph, T, "", "load",      0, 0, tl, {}});
+    a.push_back({graph, T, "", "transpose", 0, 0, tt, {}});
+    if (o.digraph) a.push_back({graph, T, "", "csr", 0, 0, tc, {}});
+    fprintf(stderr, "%s: order: %d size: %d threads: %d\n", graph.c_str(), xt.order(), xt.size(), T);
+    // engine phases
+    PerfCounters pc;
+    if (o.perf && !pc.open()) fprintf(stderr, "perf_event_open: counters unavailable\n");
+    vector<float> ref;
+    for (auto& [name, fn] : engines) {
+      vector<float> ts, ti;
+      vector<vector<float>> tis;
+      vector<double> cs(pc.enabled()? PERF_COUNTERS : 0);
+      double ds[PERF_COUNTERS];
+      int l = 0; float e = 0;
+      for (int i=0; i<o.warmup; i++)
+        fn(xt);
+      for (int i=0; i<o.repeat; i++) {
+        if (pc.enabled()) pc.start();
+        auto b = fn(xt);
+        if (pc.enabled()) { pc.stop(); pc.read(ds); }
+        for (size_t j=0; j<cs.size(); j++)
+          cs[j] += ds[j] / o.repeat;
+        if (ref.empty()) ref = b.ranks;
+        l = b.iterations;
+        e = absError(b.ranks, ref);
+        ts.push_back(b.time);
+        if (b.iterationTimes.empty()) continue;
+        ti.push_back(b.initializationTime);
+        if (tis.size() < b.iterationTimes.size()) tis.resize(b.iterationTimes.size());
+        for (size_t j=0; j<b.iterationTimes.size(); j++)
+          tis[j].push_back(b.iterationTimes[j]);
+      }
+      if (!ti.empty()) a.push_back({graph, T, name, "initialization", 0, 0, ti, {}});
+      for (size_t j=0; j<tis.size(); j++)
+        a.push_back({graph, T, name, "iteration." + to_string(j), 0, 0, tis[j], {}});
+      a.push_back({graph, T, name, "total", l, e, ts, cs});
+      auto s = benchmarkSummary(ts);
+      fprintf(stderr, "[%09.3f ms; %03d iters.] [%.4e err.] %s\n", s.median, l, e, name.c_str());
+    }
+  }
+}
+
+
+
+
+// WRITE-BENCHMARK
+// ---------------
+
+inline void writeBenchmarkJson(ostream& a, const vector<BenchmarkRecord>& rs) {
+  char buf[512];
+  a << "[\n";
+  for (size_t i=0; i<rs.size(); i++) {
+    const auto& r = rs[i];
+    auto s = benchmarkSummary(r.samples);
+    snprintf(buf, sizeof(buf), "  {\"graph\": \"%s\", \"threads\": %d, \"engine\": \"%s\", \"phase\": \"%s\", \"iterations\": %d, \"error\": %.4e, \"samples\": %zu, \"min\": %.4f, \"median\": %.4f, \"p95\": %.4f",
+      r.graph.c_str(), r.threads, r.engine.c_str(), r.phase.c_str(), r.iterations, r.error, r.samples.size(), s.min, s.median, s.p95);
+    a << buf;
+    for (size_t j=0; j<r.counters.size(); j++) {
+      snprintf(buf, sizeof(buf), ", \"%s\": %.0f", perfCounterName(j), r.counters[j]);
+      a << buf;
+    }
+    a << (i+1<rs.size()? "},\n" : "}\n");
+  }
+  a << "]\n";
+}
+
+
+inline void writeBenchmarkCsv(ostream& a, const vector<BenchmarkRecord>& rs) {
+  char buf[512];
+  a << "graph,threads,engine,phase,iterations,error,samples,min,median,p95";
+  for (int j=0; j<PERF_COUNTERS; j++)
+    a << "," << perfCounterName(j);
+  a << "\n";
+  for (const auto& r : rs) {
+    auto s = benchmarkSummary(r.samples);
+    snprintf(buf, sizeof(buf), "%s,%d,%s,%s,%d,%.4e,%zu,%.4f,%.4f,%.4f",
+      r.graph.c_str(), r.threads, r.engine.c_str(), r.phase.c_str(), r.iterations, r.error, r.samples.size(), s.min, s.median, s.p95);
+    a << buf;
+    for (int j=0; j<PERF_COUNTERS; j++) {
+      if (j < int(r.counters.size())) { snprintf(buf, sizeof(buf), ",%.0f", r.counters[j]); a << buf; }
+      else a << ",";
+    }
+    a << "\n";
+  }
+}
@@ -1,10 +1,22 @@
 #pragma once
 #include "_main.hxx"
 #include "DiGraph.hxx"
+#include "DiGraphCsr.hxx"
 #include "vertices.hxx"
 #include "edges.hxx"
 #include "transpose.hxx"
+#include "reorder.hxx"
 #include "mtx.hxx"
+#include "update.hxx"
+#include "snapshot.hxx"
+#include "benchmark.hxx"
+#include "numa.hxx"
 #include "pagerank.hxx"
 #include "pagerankSeq.hxx"
 #include "pagerankOmp.hxx"
+#include "pagerankFusedOmp.hxx"
+#include "pagerankBlockedOmp.hxx"
+#include "pagerankAdaptiveOmp.hxx"
+#include "pagerankBatchOmp.hxx"
+#include "pagerankNumaOmp.hxx"
+#include "pagerankDynamicOmp.hxx"
@@ -1,18 +1,26 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <utility>
 #include <istream>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <omp.h>
 #include "_main.hxx"
 #include "DiGraph.hxx"
+#include "DiGraphCsr.hxx"
 
 using std::string;
+using std::vector;
+using std::pair;
 using std::istream;
 using std::stringstream;
 using std::ofstream;
 using std::getline;
 using std::max;
+using std::sort;
+using std::unique;
 
 
 
@@ -59,11 +67,156 @@ auto readMtx(istream& s) {
 }
 
 
+
+
+// READ-MTX-OMP
+// ------------
+// Parses an in-memory mtx buffer with multiple threads.
+
+inline bool isBlank(char c) { return c==' ' || c=='\t' || c=='\r'; }
+inline bool isDigit(char c) { return c>='0' && c<='9'; }
+
+
+// Skip the rest of the current line (including newline).
+inline const char* skipLine(const char *p, const char *pe) {
+  while (p<pe && *p!='\n') p++;
+  return p<pe? p+1 : pe;
+}
+
+// Scan an unsigned integer after leading blanks (nullptr if none).
+inline const char* scanInt(int& a, const char *p, const char *pe) {
+  while (p<pe && isBlank(*p)) p++;
+  if (p>=pe || !isDigit(*p)) return nullptr;
+  for (a=0; p<pe && isDigit(*p); p++)
+    a = 10*a + (*p-'0');
+  return p;
+}
+
+
+// Parse header, and return offset of the first edge line (-1 if unsupported).
+inline int readMtxHeader(int& n, bool& sym, const string& buf) {
+  string ln, h0, h1, h2, h3, h4;
+  size_t i = 0;
+  while (1) {
+    if (i>=buf.size()) return -1;
+    size_t I = min(buf.find('\n', i), buf.size());
+    ln = buf.substr(i, I-i);
+    i  = I+1;
+    if (ln.find('%')!=0) break;
+    if (ln.find("%%")!=0) continue;
+    stringstream ls(ln);
+    ls >> h0 >> h1 >> h2 >> h3 >> h4;
+  }
+  if (h1!="matrix" || h2!="coordinate") return -1;
+  sym = h4=="symmetric" || h4=="skew-symmetric";
+  int r = 0, c = 0, sz = 0;
+  stringstream ls(ln);
+  ls >> r >> c >> sz;
+  n = max(r, c);
+  return min(i, buf.size());
+}
+
+
+// Parse edges in [ib, ie), each thread starting on a fresh line.
+// @returns largest vertex id seen
+inline int readMtxEdgesOmp(vector<vector<pair<int, int>>>& es, const char *ib, const char *ie, bool sym) {
+  int T = es.size(), n = 0;
+  size_t B = ceilDiv(size_t(ie-ib), size_t(T));
+  #pragma omp parallel for schedule(static,1) reduction(max:n)
+  for (int t=0; t<T; t++) {
+    auto& a = es[t];
+    const char *p  = ib + min(t*B, size_t(ie-ib));
+    const char *pe = ib + min((t+1)*B, size_t(ie-ib));
+    if (p>ib && p[-1]!='\n') p = skipLine(p, ie);
+    while (p<pe) {
+      int u, v;
+      const char *q = scanInt(u, p, ie);
+      if (q) q = scanInt(v, q, ie);
+      if (q && u>0 && v>0) {
+        a.push_back({u, v});
+        if (sym && u!=v) a.push_back({v, u});
+        n = max(n, max(u, v));
+      }
+      p = skipLine(q? q : p, ie);
+    }
+  }
+  return n;
+}
+
+
+// Group edges by source, and drop duplicates (in one sort/unique pass).
+// @param vfrom (output) edge offsets of each vertex [0, n]
+// @param eto (output) sorted targets of each vertex
+// @param es per-thread edge lists
+// @param n number of vertices (ids in [1, n])
+inline void mtxEdgesCsrOmp(vector<int>& vfrom, vector<int>& eto, const vector<vector<pair<int, int>>>& es, int n) {
+  int T = es.size(), S = n+1;
+  vector<int> deg(S), off(S+1);
+  #pragma omp parallel for schedule(static,1)
+  for (int t=0; t<T; t++) {
+    for (auto [u, v] : es[t]) {
+      #pragma omp atomic
+      deg[u]++;
+    }
+  }
+  int M = exclusiveScanOmp(off.data(), deg.data(), S);
+  off[S] = M;
+  // scatter targets to their source's segment
+  vector<int> tmp(M);
+  fillOmp(deg, 0);
+  #pragma omp parallel for schedule(static,1)
+  for (int t=0; t<T; t++) {
+    for (auto [u, v] : es[t]) {
+      int i;
+      #pragma omp atomic capture
+      i = deg[u]++;
+      tmp[off[u]+i] = v;
+    }
+  }
+  // sort each segment, and keep unique targets
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int u=0; u<S; u++) {
+    auto ib = tmp.begin()+off[u], ie = tmp.begin()+off[u+1];
+    sort(ib, ie);
+    deg[u] = unique(ib, ie) - ib;
+  }
+  vfrom.resize(S+1);
+  vfrom[S] = exclusiveScanOmp(vfrom.data(), deg.data(), S);
+  eto.resize(vfrom[S]);
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int u=0; u<S; u++)
+    copy(tmp.begin()+off[u], tmp.begin()+off[u]+deg[u], eto.begin()+vfrom[u]);
+}
+
+
+// Read mtx file as CSR (with vertex ids in [1, n]).
+// @param vfrom (output) edge offsets of each vertex [0, n]
+// @param eto (output) sorted targets of each vertex
+// @param pth path to mtx file
+// @returns n, or -1 if unsupported
+inline int readMtxCsrOmp(vector<int>& vfrom, vector<int>& eto, const char *pth) {
+  int  n; bool sym;
+  string buf = readFile(pth);
+  int  i = readMtxHeader(n, sym, buf);
+  if (i<0) return -1;
+  int  T = omp_get_max_threads();
+  vector<vector<pair<int, int>>> es(T);
+  n = max(n, readMtxEdgesOmp(es, buf.data()+i, buf.data()+buf.size(), sym));
+  mtxEdgesCsrOmp(vfrom, eto, es, n);
+  return n;
+}
+
+
 template <class G>
 void readMtx(G& a, const char *pth) {
-  string buf = readFile(pth);
-  stringstream s(buf);
-  return readMtx(a, s);
+  vector<int> vfrom, eto;
+  int n = readMtxCsrOmp(vfrom, eto, pth);
+  for (int u=1; u<=n; u++)
+    a.addVertex(u);
+  for (int u=1; u<=n; u++) {
+    for (int i=vfrom[u]; i<vfrom[u+1]; i++)
+      a.addEdgeUnchecked(u, eto[i]);
+  }
 }
 
 auto readMtx(const char *pth) {
@@ -72,6 +225,29 @@ auto readMtx(const char *pth) {
 }
 
 
+// Read mtx file directly as a CSR graph.
+inline auto readMtxCsr(const char *pth) {
+  vector<int> xfrom, eto;
+  int n = readMtxCsrOmp(xfrom, eto, pth);
+  if (n<0) return DiGraphCsr<>();
+  int M = eto.size();
+  vector<int> vkeys(n), vidx(n+1), vfrom(n+1);
+  vidx[0] = -1;
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<n; i++) {
+    vkeys[i]  = i+1;
+    vidx[i+1] = i;
+  }
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<=n; i++)
+    vfrom[i] = xfrom[i+1];
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<M; i++)
+    eto[i]--;
+  return DiGraphCsr<>(move(vkeys), move(vidx), move(vfrom), move(eto), vector<NONE>(n), vector<NONE>(M));
+}
+
+
 
 
 // WRITE-MTX
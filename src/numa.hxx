@@ -0,0 +1,198 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <omp.h>
+#include "_main.hxx"
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::to_string;
+using std::min;
+using std::max;
+
+
+
+
+// NUMA-TOPOLOGY
+// -------------
+// Read from sysfs (no libnuma); a machine without it is one node.
+
+// Parse a cpu list, such as "0-13,28-41".
+inline vector<int> parseCpuList(const string& x) {
+  vector<int> a;
+  size_t i = 0;
+  while (i < x.size()) {
+    size_t I = x.find(',', i);
+    if (I==string::npos) I = x.size();
+    string t = x.substr(i, I-i);
+    size_t k = t.find('-');
+    if (!t.empty() && t[0]>='0' && t[0]<='9') {
+      int b = stoi(t), e = k==string::npos? b : stoi(t.substr(k+1));
+      for (int c=b; c<=e; c++)
+        a.push_back(c);
+    }
+    i = I+1;
+  }
+  return a;
+}
+
+
+// CPUs of each NUMA node (only those this process may run on).
+inline vector<vector<int>> numaNodeCpus() {
+  cpu_set_t m;
+  CPU_ZERO(&m);
+  sched_getaffinity(0, sizeof(m), &m);
+  vector<vector<int>> a;
+  for (int n=0;; n++) {
+    ifstream f("/sys/devices/system/node/node" + to_string(n) + "/cpulist");
+    if (!f) break;
+    string ln; getline(f, ln);
+    vector<int> cs;
+    for (int c : parseCpuList(ln))
+      if (c < CPU_SETSIZE && CPU_ISSET(c, &m)) cs.push_back(c);
+    a.push_back(cs);
+  }
+  if (a.empty()) {
+    a.push_back({});
+    for (int c=0; c<CPU_SETSIZE; c++)
+      if (CPU_ISSET(c, &m)) a[0].push_back(c);
+  }
+  return a;
+}
+
+
+
+
+// THREAD-PINNING
+// --------------
+
+enum ThreadPinning {
+  PIN_NONE,
+  PIN_COMPACT,  // fill one node before the next
+  PIN_SCATTER   // alternate threads between nodes
+};
+
+
+inline const char* threadPinningName(ThreadPinning k) {
+  switch (k) {
+    default:          return "none";
+    case PIN_COMPACT: return "compact";
+    case PIN_SCATTER: return "scatter";
+  }
+}
+
+
+// Order in which CPUs are given to threads.
+inline vector<int> threadPinningCpus(ThreadPinning k) {
+  auto ns = numaNodeCpus();
+  vector<int> a;
+  if (k==PIN_COMPACT) {
+    for (const auto& cs : ns)
+      a.insert(a.end(), cs.begin(), cs.end());
+  }
+  else if (k==PIN_SCATTER) {
+    for (size_t i=0;; i++) {
+      size_t n0 = a.size();
+      for (const auto& cs : ns)
+        if (i < cs.size()) a.push_back(cs[i]);
+      if (a.size()==n0) break;
+    }
+  }
+  return a;
+}
+
+
+// Pin each OpenMP thread to a CPU.
+// @returns previous affinity of each thread (to restore)
+inline vector<cpu_set_t> pinThreadsOmp(ThreadPinning k) {
+  int T = omp_get_max_threads();
+  vector<cpu_set_t> a(T);
+  if (k==PIN_NONE) return a;
+  auto cs = threadPinningCpus(k);
+  if (cs.empty()) return a;
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    cpu_set_t m;
+    CPU_ZERO(&m);
+    CPU_SET(cs[t % cs.size()], &m);
+    sched_getaffinity(0, sizeof(a[t]), &a[t]);
+    sched_setaffinity(0, sizeof(m), &m);
+  }
+  return a;
+}
+
+
+// Restore affinity of each OpenMP thread.
+inline void unpinThreadsOmp(ThreadPinning k, const vector<cpu_set_t>& ms) {
+  if (k==PIN_NONE) return;
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    if (t < int(ms.size())) sched_setaffinity(0, sizeof(ms[t]), &ms[t]);
+  }
+}
+
+
+
+
+// NUMA-PLACEMENT
+// --------------
+// Node of each page of an array, with the move_pages syscall (no pages are
+// moved). Counts are per node, and a last one for pages not yet touched.
+
+struct NumaPlacement {
+  vector<string> names;
+  vector<vector<size_t>> pages;
+};
+
+
+inline vector<size_t> numaPages(const void *x, size_t bytes) {
+  const size_t B = 4096;
+  size_t P  = sysconf(_SC_PAGESIZE);
+  size_t ib = size_t(x) / P * P, ie = size_t(x) + bytes;
+  size_t N  = bytes? ceilDiv(ie-ib, P) : 0;
+  vector<size_t> a(1);  // untouched pages first, moved to the end later
+  vector<void*> ps(B);
+  vector<int>   ss(B);
+  for (size_t i=0; i<N; i+=B) {
+    size_t n = min(B, N-i);
+    for (size_t j=0; j<n; j++)
+      ps[j] = (void*) (ib + (i+j)*P);
+    if (syscall(SYS_move_pages, 0, n, ps.data(), nullptr, ss.data(), 0) != 0) return {};
+    for (size_t j=0; j<n; j++) {
+      size_t k = ss[j]>=0? ss[j]+1 : 0;
+      if (a.size() <= k) a.resize(k+1);
+      a[k]++;
+    }
+  }
+  a.push_back(a[0]);
+  a.erase(a.begin());
+  return a;
+}
+
+
+template <class T, class A>
+void numaPlacement(NumaPlacement& a, const char *name, const vector<T, A>& x) {
+  a.names.push_back(name);
+  a.pages.push_back(numaPages(x.data(), x.size()*sizeof(T)));
+}
+
+
+inline void printNumaPlacement(const NumaPlacement& a) {
+  for (size_t i=0; i<a.names.size(); i++) {
+    const auto& ps = a.pages[i];
+    printf("  %-20s {", a.names[i].c_str());
+    for (size_t n=0; n+1<ps.size(); n++)
+      printf("%snode%zu: %zu", n? ", " : "", n, ps[n]);
+    if (ps.empty()) printf("unavailable");
+    else printf("%suntouched: %zu", ps.size()>1? ", " : "", ps.back());
+    printf("} pages\n");
+  }
+}
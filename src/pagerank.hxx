@@ -14,9 +14,12 @@ struct PagerankOptions {
   T   damping;
   T   tolerance;
   int maxIterations;
+  T   frontierTolerance;  // relative rank change that marks out-neighbours affected (dynamic)
+  T   skipTolerance;      // relative rank change below which a vertex is frozen (adaptive)
+  bool asynchronous;      // update ranks in place, instead of into a separate vector (adaptive)
 
-  PagerankOptions(int repeat=1, T damping=0.85, T tolerance=1e-6, int maxIterations=500) :
-  repeat(repeat), damping(damping), tolerance(tolerance), maxIterations(maxIterations) {}
+  PagerankOptions(int repeat=1, T damping=0.85, T tolerance=1e-6, int maxIterations=500, T frontierTolerance=1e-6, T skipTolerance=1e-6, bool asynchronous=false) :
+  repeat(repeat), damping(damping), tolerance(tolerance), maxIterations(maxIterations), frontierTolerance(frontierTolerance), skipTolerance(skipTolerance), asynchronous(asynchronous) {}
 };
 
 
@@ -25,10 +28,15 @@ struct PagerankResult {
   vector<T> ranks;
   int   iterations;
   float time;
+  float preprocessingTime;  // reordering, partitioning (not included in time)
+  vector<size_t> verticesProcessed;  // per iteration (adaptive)
+  vector<size_t> edgesProcessed;     // per iteration (adaptive)
+  float initializationTime;          // initial ranks, factors (last run)
+  vector<float> iterationTimes;      // time of each iteration (last run)
 
-  PagerankResult(vector<T>&& ranks, int iterations=0, float time=0) :
-  ranks(ranks), iterations(iterations), time(time) {}
+  PagerankResult(vector<T>&& ranks, int iterations=0, float time=0, float preprocessingTime=0) :
+  ranks(ranks), iterations(iterations), time(time), preprocessingTime(preprocessingTime), initializationTime(0) {}
 
-  PagerankResult(vector<T>& ranks, int iterations=0, float time=0) :
-  ranks(move(ranks)), iterations(iterations), time(time) {}
+  PagerankResult(vector<T>& ranks, int iterations=0, float time=0, float preprocessingTime=0) :
+  ranks(move(ranks)), iterations(iterations), time(time), preprocessingTime(preprocessingTime), initializationTime(0) {}
 };
@@ -0,0 +1,207 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include "_main.hxx"
+#include "transpose.hxx"
+#include "pagerank.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::move;
+using std::swap;
+using std::numeric_limits;
+
+
+
+
+// Iterations without a new lowest error, after which to stop.
+#define PAGERANK_ADAPTIVE_STALL 8
+
+
+// Work done, and rank change, in one iteration.
+template <class T>
+struct PagerankAdaptiveStep {
+  T      error;       // sum of rank change
+  size_t vertices;
+  size_t edges;
+  size_t changedEdges;  // out-edges of vertices that still change
+};
+
+
+// Sum of dead-end ranks.
+template <class T, class J>
+T pagerankAdaptiveDeadOmp(const vector<T>& r, const J& vdata, int N) {
+  T a = T();
+  #pragma omp parallel for schedule(static,4096) reduction(+:a)
+  for (int u=0; u<N; u++)
+    if (vdata[u] == 0) a += r[u];
+  return a;
+}
+
+// Sum of ranks (accumulated in double, as it is compared against 1).
+template <class T>
+T pagerankAdaptiveRankSumOmp(const vector<T>& r, int N) {
+  double a = 0;
+  #pragma omp parallel for schedule(static,4096) reduction(+:a)
+  for (int u=0; u<N; u++)
+    a += r[u];
+  return T(a);
+}
+
+// Sum of contributions of in-neighbours (read atomically, if asynchronous).
+template <bool ASYNC, class T, class J>
+inline T pagerankAdaptiveGather(const vector<T>& c, const J& efrom, int i, int I) {
+  if (!ASYNC) return sumAt(c, slice(efrom, i, I));
+  T a = T();
+  for (; i<I; i++) {
+    T cu;
+    #pragma omp atomic read
+    cu = c[efrom[i]];
+    a += cu;
+  }
+  return a;
+}
+
+// Recompute active vertices (into a, or in place if asynchronous), and flag
+// those that still change.
+template <bool ASYNC, class T, class J>
+PagerankAdaptiveStep<T> pagerankAdaptiveOmpOnce(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const vector<char>& vact, vector<char>& vchg, const J& vfrom, const J& efrom, const vector<int>& ofrom, int N, T c0, T K) {
+  T e = T();
+  size_t nv = 0, ne = 0, no = 0;
+  #pragma omp parallel for schedule(static,4096) reduction(+:e,nv,ne,no)
+  for (int v=0; v<N; v++) {
+    vchg[v] = 0;
+    if (!vact[v]) continue;
+    int i = vfrom[v], I = vfrom[v+1];
+    T rv = c0 + pagerankAdaptiveGather<ASYNC>(c, efrom, i, I);
+    T dv = rv - r[v];
+    e  += abs(dv);
+    nv += 1;
+    ne += I-i;
+    if (ASYNC) {
+      T cv = rv*f[v];
+      r[v] = rv;
+      #pragma omp atomic write
+      c[v] = cv;
+    }
+    else a[v] = rv;
+    if (abs(dv) <= K*rv) continue;
+    vchg[v] = 1;
+    no += ofrom[v+1] - ofrom[v];
+  }
+  return {e, nv, ne, no};
+}
+
+// Activate vertices that changed, and their out-neighbours.
+inline void pagerankAdaptiveMarkOmp(vector<char>& vact, const vector<char>& vchg, const vector<int>& ofrom, const vector<int>& oto, int N) {
+  fillOmp(vact, char());
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int v=0; v<N; v++) {
+    if (!vchg[v]) continue;
+    #pragma omp atomic write
+    vact[v] = 1;
+    for (int k=ofrom[v]; k<ofrom[v+1]; k++) {
+      char aw;
+      #pragma omp atomic read
+      aw = vact[oto[k]];
+      if (aw) continue;
+      #pragma omp atomic write
+      vact[oto[k]] = 1;
+    }
+  }
+}
+
+// Copy new ranks of active vertices, and update their contributions.
+template <class T>
+void pagerankAdaptiveCommitOmp(vector<T>& r, vector<T>& c, const vector<T>& a, const vector<T>& f, const vector<char>& vact, int N) {
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<N; v++)
+    if (vact[v]) { r[v] = a[v]; c[v] = a[v]*f[v]; }
+}
+
+template <bool ASYNC, class T, class J>
+int pagerankAdaptiveOmpLoop(vector<size_t>& nvs, vector<size_t>& nes, vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, vector<char>& vact, vector<char>& vchg, const J& vfrom, const J& efrom, const J& vdata, const vector<int>& ofrom, const vector<int>& oto, int N, T p, T E, T K, int L, vector<float> *ts=nullptr) {
+  size_t M = oto.size();
+  int l = 0, lb = 0;
+  T e0 = T(), eb = numeric_limits<T>::max();
+  T D  = pagerankAdaptiveDeadOmp(r, vdata, N);
+  T cs = (1-p)/N + p*D/N;
+  auto t0 = timeNow();
+  for (; l<L; l++) {
+    T c0 = (1-p)/N + p*D/N;
+    // in-place updates see a stale dead-end rank, and the rank sum drifts from 1;
+    // teleport part of the missing rank, without touching frozen ranks
+    if (ASYNC) c0 += (1-p)*(1 - pagerankAdaptiveRankSumOmp(r, N))/N;
+    // frozen ranks miss changes in teleport contribution, so sweep all once it drifts
+    if (abs(c0-cs) > K*c0) { fillOmp(vact, char(1)); cs = c0; }
+    auto s = pagerankAdaptiveOmpOnce<ASYNC>(a, r, c, f, vact, vchg, vfrom, efrom, ofrom, N, c0, K);
+    if (!ASYNC) pagerankAdaptiveCommitOmp(r, c, a, f, vact, N);
+    nvs.push_back(s.vertices);
+    nes.push_back(s.edges);
+    D = pagerankAdaptiveDeadOmp(r, vdata, N);
+    if (ts) { auto t1 = timeNow(); ts->push_back(duration(t0, t1)); t0 = t1; }
+    if (s.error < E || s.error == e0) break;
+    // skipped or in-place updates rarely repeat an error exactly, so stop once it no longer falls
+    if (s.error < eb) { eb = s.error; lb = l; }
+    else if (l-lb >= PAGERANK_ADAPTIVE_STALL) break;
+    e0 = s.error;
+    // marking costs about as much as a sweep when many vertices still change
+    if (s.changedEdges > M/4) fillOmp(vact, char(1));
+    else pagerankAdaptiveMarkOmp(vact, vchg, ofrom, oto, N);
+  }
+  return l;
+}
+
+template <class T, class J>
+int pagerankAdaptiveOmpCore(vector<size_t>& nvs, vector<size_t>& nes, vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, vector<char>& vact, vector<char>& vchg, const J& vfrom, const J& efrom, const J& vdata, const vector<int>& ofrom, const vector<int>& oto, int N, const vector<T> *q, T p, T E, T K, bool async, int L, float *ti=nullptr, vector<float> *ts=nullptr) {
+  auto t0 = timeNow();
+  if (q) copyOmp(r, *q);
+  else fillOmp(r, T(1)/N);
+  pagerankFactorOmp(f, vfrom, efrom, vdata, N, p);
+  multiplyOmp(c, r, f);
+  fillOmp(vact, char(1));
+  nvs.clear();
+  nes.clear();
+  if (ti) *ti = duration(t0, timeNow());
+  if (ts) ts->clear();
+  if (async) return pagerankAdaptiveOmpLoop<true> (nvs, nes, a, r, c, f, vact, vchg, vfrom, efrom, vdata, ofrom, oto, N, p, E, K, L, ts);
+  else       return pagerankAdaptiveOmpLoop<false>(nvs, nes, a, r, c, f, vact, vchg, vfrom, efrom, vdata, ofrom, oto, N, p, E, K, L, ts);
+}
+
+
+// Find pagerank accelerated using OpenMP, skipping vertices that have converged.
+// A vertex is frozen (its contribution kept as is) once its relative rank change
+// is within skip tolerance, and recomputed when an in-neighbour changes more.
+// If asynchronous, ranks are updated in place (Gauss-Seidel), and the rank sum
+// kept near 1 through the teleport contribution; results depend on thread timing.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param q initial ranks (optional)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500, skipTolerance=1e-6, asynchronous=false}
+// @returns {ranks, iterations, time, preprocessingTime, verticesProcessed, edgesProcessed, initializationTime, iterationTimes}
+template <class G, class T=float>
+PagerankResult<T> pagerankAdaptiveOmp(const G& xt, const vector<T> *q=nullptr, PagerankOptions<T> o={}) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  T    K = o.skipTolerance;
+  int  L = o.maxIterations, l;
+  const auto& vfrom = sourceOffsets(xt);
+  const auto& efrom = destinationIndices(xt);
+  const auto& vdata = vertexData(xt);
+  int  N = xt.order();
+  // out-edges, to find vertices affected by a change
+  vector<int> ofrom, oto; vector<NONE> odata;
+  float tp = measureDuration([&]() { transposeCsrOmp(ofrom, oto, odata, vfrom, efrom, vector<NONE>(xt.size())); });
+  vector<T> a(N), r(N), f(N), c(N);
+  vector<char> vact(N), vchg(N);
+  vector<size_t> nvs, nes;
+  float ti = 0; vector<float> ts;
+  float t = measureDuration([&]() { l = pagerankAdaptiveOmpCore(nvs, nes, a, r, f, c, vact, vchg, vfrom, efrom, vdata, ofrom, oto, N, q, p, E, K, o.asynchronous, L, &ti, &ts); }, o.repeat);
+  PagerankResult<T> b(vertexContainer(xt, r), l, t, tp);
+  b.verticesProcessed = move(nvs);
+  b.edgesProcessed    = move(nes);
+  b.initializationTime = ti;
+  b.iterationTimes     = move(ts);
+  return b;
+}
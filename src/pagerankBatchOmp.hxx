@@ -0,0 +1,255 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "DiGraphCsr.hxx"
+#include "pagerank.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::pair;
+using std::min;
+using std::max;
+using std::swap;
+using std::fill;
+using std::sort;
+using std::unique;
+
+
+
+
+// PAGERANK-BATCH
+// --------------
+// Ranks of K queries are kept as an N x K row-major block, so that each
+// in-edge is read once for all queries, with a SIMD loop over queries.
+// Teleport vectors are kept sparse, as {vertex index, weight} lists.
+
+#define PAGERANK_BATCH_BUDGET (size_t(1) << 30)
+
+
+// Convert teleport vectors (by vertex id) to normalized sparse lists (by index).
+template <class G, class T>
+auto pagerankBatchTeleports(const G& xt, const vector<vector<T>>& ts) {
+  auto ks = vertices(xt);
+  int  N  = ks.size();
+  vector<vector<pair<int, T>>> a(ts.size());
+  for (size_t q=0; q<ts.size(); q++) {
+    const auto& t = ts[q];
+    T s = T();
+    for (int i=0; i<N; i++)
+      if (ks[i] < int(t.size()) && t[ks[i]] != T()) { a[q].push_back({i, t[ks[i]]}); s += t[ks[i]]; }
+    if (s == T()) {  // no personalization, use uniform
+      a[q].clear();
+      for (int i=0; i<N; i++)
+        a[q].push_back({i, T(1)});
+      s = T(N);
+    }
+    for (auto& [i, w] : a[q])
+      w /= s;
+  }
+  return a;
+}
+
+// Convert seed sets (vertex ids) to sparse teleport lists (by index).
+template <class T, class G>
+auto pagerankBatchSeeds(const G& xt, const vector<vector<int>>& ss) {
+  auto ks   = vertices(xt);
+  auto vidx = vertexIndicesOmp(ks, xt.span());
+  int  N    = ks.size();
+  vector<vector<pair<int, T>>> a(ss.size());
+  for (size_t q=0; q<ss.size(); q++) {
+    for (int u : ss[q])
+      if (u >= 0 && u < xt.span() && vidx[u] >= 0) a[q].push_back({vidx[u], T()});
+    sort(a[q].begin(), a[q].end());
+    a[q].erase(unique(a[q].begin(), a[q].end()), a[q].end());
+    if (a[q].empty()) {  // no valid seeds, use uniform
+      for (int i=0; i<N; i++)
+        a[q].push_back({i, T()});
+    }
+    for (auto& [i, w] : a[q])
+      w = T(1)/a[q].size();
+  }
+  return a;
+}
+
+
+
+
+template <class T, class J>
+void pagerankBatchOmpOnce(vector<T>& a, const vector<T>& c, const J& vfrom, const J& efrom, int N, int K) {
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int v=0; v<N; v++) {
+    T *av = a.data() + size_t(v)*K;
+    #pragma omp simd
+    for (int k=0; k<K; k++)
+      av[k] = T();
+    for (int i=vfrom[v]; i<vfrom[v+1]; i++) {
+      const T *cu = c.data() + size_t(efrom[i])*K;
+      #pragma omp simd
+      for (int k=0; k<K; k++)
+        av[k] += cu[k];
+    }
+  }
+}
+
+// Add teleport contribution t_k * ((1-p) + p*D_k) of each query.
+template <class T>
+void pagerankBatchTeleportOmp(vector<T>& a, const vector<vector<pair<int, T>>>& ts, const vector<int>& qs, const vector<T>& D, int K, T p) {
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int k=0; k<K; k++) {
+    T w = (1-p) + p*D[k];
+    for (auto [i, x] : ts[qs[k]])
+      a[size_t(i)*K + k] += w*x;
+  }
+}
+
+// Find rank change (e), and dead-end rank (D) of each query, and contributions (c) for the next iteration.
+template <class T, class J>
+void pagerankBatchErrorOmp(vector<T>& e, vector<T>& D, vector<T>& c, const vector<T>& a, const vector<T>& r, const vector<T>& f, const J& vdata, int N, int K) {
+  T *ep = e.data(), *Dp = D.data();
+  fill(ep, ep+K, T());
+  fill(Dp, Dp+K, T());
+  #pragma omp parallel for schedule(static,4096) reduction(+:ep[:K],Dp[:K])
+  for (int v=0; v<N; v++) {
+    const T *av = a.data() + size_t(v)*K;
+    const T *rv = r.data() + size_t(v)*K;
+    T *cv = c.data() + size_t(v)*K;
+    T  fv = f[v];
+    #pragma omp simd
+    for (int k=0; k<K; k++) {
+      ep[k] += abs(av[k] - rv[k]);
+      cv[k]  = av[k] * fv;
+    }
+    if (vdata[v] != 0) continue;
+    #pragma omp simd
+    for (int k=0; k<K; k++)
+      Dp[k] += av[k];
+  }
+}
+
+// Keep only listed columns of a row-major block.
+template <class T>
+void pagerankBatchCompactOmp(vector<T>& a, const vector<T>& x, const vector<int>& ks, int N, int K) {
+  int K1 = ks.size();
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<N; v++) {
+    for (int j=0; j<K1; j++)
+      a[size_t(v)*K1 + j] = x[size_t(v)*K + ks[j]];
+  }
+}
+
+
+// Find ranks of a chunk of queries, retiring each one as it converges.
+// @param as (output) ranks of each query (by index)
+// @param ls (output) iterations of each query
+// @param qs queries in this chunk
+template <class T, class J>
+void pagerankBatchOmpLoop(vector<vector<T>>& as, vector<int>& ls, vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, const J& vfrom, const J& efrom, const J& vdata, const vector<vector<pair<int, T>>>& ts, vector<int> qs, int N, T p, T E, int L) {
+  int K = qs.size();
+  vector<T> e(K), e0(K), D(K);
+  vector<int> ks;
+  // start from the teleport vectors
+  fillOmp(r.data(), size_t(N)*K, T());
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int k=0; k<K; k++) {
+    for (auto [i, x] : ts[qs[k]])
+      r[size_t(i)*K + k] = x;
+  }
+  pagerankBatchErrorOmp(e, D, c, r, r, f, vdata, N, K);
+  for (int l=0; K>0; l++) {
+    pagerankBatchOmpOnce(a, c, vfrom, efrom, N, K);
+    pagerankBatchTeleportOmp(a, ts, qs, D, K, p);
+    pagerankBatchErrorOmp(e, D, c, a, r, f, vdata, N, K);
+    // retire converged queries
+    ks.clear();
+    for (int k=0; k<K; k++) {
+      if (e[k] < E || e[k] == e0[k] || l+1 >= L) {
+        int q = qs[k];
+        as[q].resize(N);
+        #pragma omp parallel for schedule(static,4096)
+        for (int v=0; v<N; v++)
+          as[q][v] = a[size_t(v)*K + k];
+        ls[q] = l;
+      }
+      else ks.push_back(k);
+    }
+    if (int(ks.size()) == K) { swap(a, r); swap(e0, e); continue; }
+    // drop retired columns (ranks into r, contributions via a)
+    int K1 = ks.size();
+    pagerankBatchCompactOmp(r, a, ks, N, K);
+    pagerankBatchCompactOmp(a, c, ks, N, K);
+    swap(a, c);
+    for (int j=0; j<K1; j++) {
+      qs[j] = qs[ks[j]];
+      e0[j] = e[ks[j]];
+      D[j]  = D[ks[j]];
+    }
+    qs.resize(K1);
+    K = K1;
+  }
+}
+
+
+template <class T, class J>
+void pagerankBatchOmpCore(vector<vector<T>>& as, vector<int>& ls, vector<float>& ts, const J& vfrom, const J& efrom, const J& vdata, const vector<vector<pair<int, T>>>& xs, int N, T p, T E, int L, int repeat, size_t budget) {
+  int Q  = xs.size();
+  int KC = int(min(size_t(max(Q, 1)), max(size_t(1), budget / (3*sizeof(T)*max(N, 1)))));
+  vector<T> a(size_t(N)*KC), r(size_t(N)*KC), c(size_t(N)*KC), f(N);
+  pagerankFactorOmp(f, vfrom, efrom, vdata, N, p);
+  for (int q=0; q<Q; q+=KC) {
+    vector<int> qs;
+    for (int k=q; k<min(q+KC, Q); k++)
+      qs.push_back(k);
+    float t = measureDuration([&]() { pagerankBatchOmpLoop(as, ls, a, r, c, f, vfrom, efrom, vdata, xs, qs, N, p, E, L); }, repeat);
+    for (int k : qs)
+      ts[k] = t;
+  }
+}
+
+
+template <class G, class T>
+vector<PagerankResult<T>> pagerankBatchOmpSparse(const G& xt, const vector<vector<pair<int, T>>>& xs, PagerankOptions<T> o, size_t budget) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  int  L = o.maxIterations;
+  const auto& vfrom = sourceOffsets(xt);
+  const auto& efrom = destinationIndices(xt);
+  const auto& vdata = vertexData(xt);
+  int  N = xt.order(), Q = xs.size();
+  vector<vector<T>> as(Q);
+  vector<int>   ls(Q);
+  vector<float> ts(Q);
+  pagerankBatchOmpCore(as, ls, ts, vfrom, efrom, vdata, xs, N, p, E, L, o.repeat, budget);
+  vector<PagerankResult<T>> a;
+  for (int q=0; q<Q; q++)
+    a.push_back(PagerankResult<T>(vertexContainer(xt, as[q]), ls[q], ts[q]));
+  return a;
+}
+
+
+// Find personalized pagerank of many queries at once, accelerated using OpenMP.
+// Queries are processed in chunks that fit the memory budget, and each query
+// is dropped from its chunk once it converges.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param ts teleport vector of each query, by vertex id (normalized; all zero for uniform)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @param budget bytes for rank blocks (3 x N x chunk size)
+// @returns {ranks, iterations, time of its chunk} of each query
+template <class G, class T=float>
+vector<PagerankResult<T>> pagerankBatchOmp(const G& xt, const vector<vector<T>>& ts, PagerankOptions<T> o={}, size_t budget=PAGERANK_BATCH_BUDGET) {
+  return pagerankBatchOmpSparse(xt, pagerankBatchTeleports(xt, ts), o, budget);
+}
+
+
+// Find personalized pagerank of many seed sets at once, accelerated using OpenMP.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param ss seed vertex ids of each query (teleport uniformly to its seeds)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @param budget bytes for rank blocks (3 x N x chunk size)
+// @returns {ranks, iterations, time of its chunk} of each query
+template <class G, class T=float>
+vector<PagerankResult<T>> pagerankBatchOmp(const G& xt, const vector<vector<int>>& ss, PagerankOptions<T> o={}, size_t budget=PAGERANK_BATCH_BUDGET) {
+  return pagerankBatchOmpSparse(xt, pagerankBatchSeeds<T>(xt, ss), o, budget);
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "edges.hxx"
+#include "transpose.hxx"
+#include "reorder.hxx"
+#include "pagerank.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::swap;
+using std::min;
+using std::max;
+
+
+
+
+// Bins are counted per (destination, source) partition pair, so partitions
+// are made larger if there would be more than this many.
+#define PAGERANK_BLOCKED_PARTITIONS 1024
+
+
+// Partition-centric (PCPM) layout of a graph.
+// A source writes its contribution once per destination partition it links
+// to (an update). Updates are binned by destination partition, so that each
+// partition's gather stays within a cache-sized slice of the rank vector.
+struct PagerankBins {
+  int B = 0, P = 0;   // partition size, number of partitions (0 if not blocked)
+  vector<int> gfrom;  // update range of each source [0, N]
+  vector<int> gidx;   // bin slot of each update
+  vector<int> bfrom;  // slot range of each destination partition [0, P]
+  vector<int> dfrom;  // destination range of each slot [0, U]
+  vector<int> dto;    // destination of each edge, by slot
+};
+
+
+// Build bins from CSR arrays of a transpose graph.
+// @param B partition size (raised to keep partitions within PAGERANK_BLOCKED_PARTITIONS)
+template <class J>
+void pagerankBinsOmp(PagerankBins& a, const J& vfrom, const J& efrom, int N, int B) {
+  B = max(B, max(1, ceilDiv(N, PAGERANK_BLOCKED_PARTITIONS)));
+  int M = vfrom[N], P = ceilDiv(N, B);
+  vector<int> ofrom, oto; vector<NONE> odata;
+  transposeCsrOmp(ofrom, oto, odata, vfrom, efrom, vector<NONE>(M));
+  vector<int> gdeg(N), cnt(size_t(P)*P), off(size_t(P)*P+1);
+  // count updates of each source, and of each (destination, source) partition pair
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int s=0; s<P; s++) {
+    for (int u=s*B; u<min((s+1)*B, N); u++) {
+      for (int k=ofrom[u], e=-1; k<ofrom[u+1]; k++) {
+        int d = oto[k]/B;
+        if (d==e) continue;
+        cnt[d*P+s]++; gdeg[u]++; e = d;
+      }
+    }
+  }
+  a.B = B; a.P = P;
+  a.gfrom.resize(N+1);
+  int U = a.gfrom[N] = exclusiveScanOmp(a.gfrom.data(), gdeg.data(), N);
+  off[P*P] = exclusiveScanOmp(off.data(), cnt.data(), P*P);
+  a.bfrom.resize(P+1);
+  for (int d=0; d<=P; d++)
+    a.bfrom[d] = off[d*P];
+  // assign slots to updates, and count destinations of each slot
+  vector<int> dcnt(U);
+  a.gidx.resize(U);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int s=0; s<P; s++) {
+    vector<int> cur(P);
+    for (int d=0; d<P; d++)
+      cur[d] = off[d*P+s];
+    for (int u=s*B; u<min((s+1)*B, N); u++) {
+      for (int k=ofrom[u], e=-1, g=a.gfrom[u], i=0; k<ofrom[u+1]; k++) {
+        int d = oto[k]/B;
+        if (d!=e) { i = cur[d]++; a.gidx[g++] = i; e = d; }
+        dcnt[i]++;
+      }
+    }
+  }
+  a.dfrom.resize(U+1);
+  a.dfrom[U] = exclusiveScanOmp(a.dfrom.data(), dcnt.data(), U);
+  // fill destinations of each slot
+  a.dto.resize(M);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int s=0; s<P; s++) {
+    for (int u=s*B; u<min((s+1)*B, N); u++) {
+      for (int k=ofrom[u], e=-1, g=a.gfrom[u]-1, j=0; k<ofrom[u+1]; k++) {
+        int d = oto[k]/B;
+        if (d!=e) { j = a.dfrom[a.gidx[++g]]; e = d; }
+        a.dto[j++] = oto[k];
+      }
+    }
+  }
+}
+
+
+template <class T>
+void pagerankBlockedOmpOnce(vector<T>& a, vector<T>& m, const vector<T>& c, const PagerankBins& b, int N, T c0) {
+  int B = b.B, P = b.P;
+  // scatter contributions into bins, one source partition at a time
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int s=0; s<P; s++) {
+    for (int u=s*B; u<min((s+1)*B, N); u++) {
+      T cu = c[u];
+      for (int g=b.gfrom[u]; g<b.gfrom[u+1]; g++)
+        m[b.gidx[g]] = cu;
+    }
+  }
+  // gather bins, one destination partition at a time
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int d=0; d<P; d++) {
+    fill(a.data()+d*B, min(B, N-d*B), c0);
+    for (int i=b.bfrom[d]; i<b.bfrom[d+1]; i++) {
+      T mi = m[i];
+      for (int j=b.dfrom[i]; j<b.dfrom[i+1]; j++)
+        a[b.dto[j]] += mi;
+    }
+  }
+}
+
+template <class T, class J>
+int pagerankBlockedOmpLoop(vector<T>& a, vector<T>& r, const vector<T>& f, vector<T>& c, vector<T>& m, const J& vfrom, const J& efrom, const J& vdata, const PagerankBins& b, int N, T p, T E, int L, vector<float> *ts=nullptr) {
+  int l = 0;
+  T e0 = T();
+  auto t0 = timeNow();
+  for (; l<L; l++) {
+    T c0 = pagerankTeleportOmp(r, vfrom, efrom, vdata, N, p);
+    multiplyOmp(c, r, f);
+    pagerankBlockedOmpOnce(a, m, c, b, N, c0);
+    T e1 = absErrorOmp(a, r);
+    if (ts) { auto t1 = timeNow(); ts->push_back(duration(t0, t1)); t0 = t1; }
+    if (e1 < E || e1 == e0) break;
+    swap(a, r);
+    e0 = e1;
+  }
+  return l;
+}
+
+template <class T, class J>
+int pagerankBlockedOmpCore(vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, vector<T>& m, const J& vfrom, const J& efrom, const J& vdata, const PagerankBins& b, int N, const vector<T> *q, T p, T E, int L, float *ti=nullptr, vector<float> *ts=nullptr) {
+  auto t0 = timeNow();
+  if (q) copyOmp(r, *q);
+  else fillOmp(r, T(1)/N);
+  pagerankFactorOmp(f, vfrom, efrom, vdata, N, p);
+  if (ti) *ti = duration(t0, timeNow());
+  if (ts) ts->clear();
+  if (b.P==0) return pagerankOmpLoop(a, r, f, c, vfrom, efrom, vdata, N, p, E, L, ts);
+  return pagerankBlockedOmpLoop(a, r, f, c, m, vfrom, efrom, vdata, b, N, p, E, L, ts);
+}
+
+
+// Find pagerank accelerated using OpenMP, with partition-centric propagation.
+// Vertices are first relabeled with a locality-improving order; ranks are
+// returned by vertex id, and preprocessing time is reported separately.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param q initial ranks (optional)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @param k vertex order to relabel with
+// @param B partition size (in vertices; 64K floats fit in a 256KB L2), or 0 to pull as pagerankOmp
+//          (raised if the graph would have over PAGERANK_BLOCKED_PARTITIONS partitions)
+// @returns {ranks, iterations, time, preprocessingTime, initializationTime, iterationTimes}
+template <class G, class T=float>
+PagerankResult<T> pagerankBlockedOmp(const G& xt, const vector<T> *q=nullptr, PagerankOptions<T> o={}, VertexOrder k=ORDER_NONE, int B=65536) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  int  L = o.maxIterations, l;
+  const auto& xfrom = sourceOffsets(xt);
+  const auto& xto   = destinationIndices(xt);
+  const auto& xdata = vertexData(xt);
+  int  N  = xt.order();
+  auto ks = vertices(xt);
+  vector<int> vfrom, efrom, vdata;
+  vector<T> qs, *qp = nullptr;
+  PagerankBins b;
+  float tp = measureDuration([&]() {
+    auto is = vertexOrder(xfrom, xto, xdata, N, k);
+    relabelCsrOmp(vfrom, efrom, vdata, is, xfrom, xto, xdata);
+    if (B>0) pagerankBinsOmp(b, vfrom, efrom, N, B);
+    auto js = ks;
+    for (int i=0; i<N; i++)
+      ks[i] = js[is[i]];
+    if (q) { qs.resize(N); qp = &qs; }
+    for (int i=0; q && i<N; i++)
+      qs[i] = (*q)[is[i]];
+  });
+  vector<T> a(N), r(N), f(N), c(N), m(B>0? b.gfrom[N] : 0);
+  float ti = 0; vector<float> ts;
+  float t = measureDuration([&]() { l = pagerankBlockedOmpCore(a, r, f, c, m, vfrom, efrom, vdata, b, N, qp, p, E, L, &ti, &ts); }, o.repeat);
+  PagerankResult<T> y(vertexContainer(xt, a, ks), l, t, tp);
+  y.initializationTime = ti;
+  y.iterationTimes     = move(ts);
+  return y;
+}
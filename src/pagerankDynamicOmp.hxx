@@ -0,0 +1,230 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include "_main.hxx"
+#include "pagerank.hxx"
+
+using std::vector;
+using std::pair;
+using std::unordered_map;
+using std::swap;
+using std::max;
+
+
+
+
+// Ranks only depend on the teleport contribution (c0) by a common scale, as
+// r = c0 (I - A)^-1 1, where A spreads rank along out-edges of non dead-ends.
+// So ranks of the updated graph are found with the c0 of the previous ranks,
+// which stay exact for vertices away from the update, and are then scaled to
+// sum to 1. This way, a change of dead-ends does not affect all vertices.
+
+// Teleport contribution of the previous ranks (with vertices and dead-ends as
+// they were before the update).
+template <class T, class H>
+T pagerankDynamicTeleportBefore(const vector<T>& q, const H& xt, const vector<pair<int, int>>& deletions, const vector<pair<int, int>>& insertions, T p) {
+  int S = xt.span(), Q = min(S, int(q.size())), N = 0;
+  T D = T();
+  #pragma omp parallel for schedule(static,4096) reduction(+:D,N)
+  for (int u=0; u<Q; u++) {
+    if (!xt.hasVertex(u) || !(q[u] > T())) continue;
+    ++N;
+    if (xt.vertexData(u) == 0) D += q[u];
+  }
+  unordered_map<int, int> dd;
+  for (auto [u, v] : deletions)  dd[u]++;
+  for (auto [u, v] : insertions) dd[u]--;
+  for (auto [u, k] : dd) {
+    if (u >= Q || !(q[u] > T())) continue;
+    int d1 = xt.vertexData(u), d0 = d1 + k;
+    if (d1==0 && d0>0) D -= q[u];
+    if (d1>0 && d0==0) D += q[u];
+  }
+  return N>0? (1-p)/N + p*D/N : T();
+}
+
+// Start from previous ranks; vertices without one start at c0, and are affected.
+template <class T, class H>
+void pagerankDynamicInitOmp(vector<T>& r, vector<char>& vaff, const vector<T>& q, const H& xt, int S, T c0) {
+  int Q = q.size();
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<S; v++) {
+    T qv = v<Q? q[v] : T();
+    if (!xt.hasVertex(v)) r[v] = T();
+    else if (qv > T()) r[v] = qv;
+    else { r[v] = c0; vaff[v] = 1; }
+  }
+}
+
+template <class G>
+void pagerankDynamicAffected(vector<char>& a, const G& x, const vector<pair<int, int>>& deletions, const vector<pair<int, int>>& insertions) {
+  auto mark = [&](int u, int v) {
+    a[u] = a[v] = 1;
+    for (int w : x.edges(u))
+      a[w] = 1;
+  };
+  for (auto [u, v] : deletions)  mark(u, v);
+  for (auto [u, v] : insertions) mark(u, v);
+}
+
+template <class T, class H>
+void pagerankDynamicFactorOmp(vector<T>& a, const H& xt, int S, T p) {
+  #pragma omp parallel for schedule(static,4096)
+  for (int u=0; u<S; u++) {
+    int d = xt.vertexData(u);
+    a[u] = d>0? p/d : 0;
+  }
+}
+
+// Recompute affected vertices (into a), and flag those that change a lot and
+// have not yet affected their out-neighbours.
+// @returns sum of rank change
+template <class T, class H>
+T pagerankDynamicOmpOnce(vector<T>& a, const vector<T>& r, const vector<T>& c, const vector<char>& vaff, vector<char>& vchg, const H& xt, int S, T c0, T F) {
+  T e = T();
+  #pragma omp parallel for schedule(dynamic,2048) reduction(+:e)
+  for (int v=0; v<S; v++) {
+    vchg[v] = 0;
+    if (!vaff[v]) continue;
+    T rv = c0 + sumAt(c, xt.edges(v));
+    T ev = abs(rv - r[v]);
+    e   += ev;
+    a[v] = rv;
+    if (vaff[v]==1 && ev > F * max(rv, r[v])) vchg[v] = 1;
+  }
+  return e;
+}
+
+// Copy new ranks of affected vertices, and update their contributions.
+template <class T>
+void pagerankDynamicCommitOmp(vector<T>& r, vector<T>& c, const vector<T>& a, const vector<T>& f, const vector<char>& vaff, int S) {
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<S; v++)
+    if (vaff[v]) { r[v] = a[v]; c[v] = a[v]*f[v]; }
+}
+
+// Affect out-neighbours of flagged vertices; they stay affected, so each
+// vertex is expanded only once (marked 2).
+// @returns number of newly affected vertices (about)
+template <class G>
+size_t pagerankDynamicExpandOmp(vector<char>& vaff, const vector<char>& vchg, const G& x, int S) {
+  size_t a = 0;
+  #pragma omp parallel for schedule(dynamic,2048) reduction(+:a)
+  for (int v=0; v<S; v++) {
+    if (!vchg[v]) continue;
+    #pragma omp atomic write
+    vaff[v] = 2;
+    for (int w : x.edges(v)) {
+      char aw;
+      #pragma omp atomic read
+      aw = vaff[w];
+      if (aw) continue;
+      #pragma omp atomic write
+      vaff[w] = 1;
+      ++a;
+    }
+  }
+  return a;
+}
+
+// Mark all vertices as affected.
+template <class H>
+void pagerankDynamicAffectAllOmp(vector<char>& vaff, const H& xt, int S) {
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<S; v++)
+    vaff[v] = xt.hasVertex(v)? 2 : 0;
+}
+
+// Sum of dead-end ranks.
+template <class T, class H>
+T pagerankDynamicDeadOmp(const vector<T>& r, const H& xt, int S) {
+  T a = T();
+  #pragma omp parallel for schedule(static,4096) reduction(+:a)
+  for (int u=0; u<S; u++)
+    if (xt.hasVertex(u) && xt.vertexData(u) == 0) a += r[u];
+  return a;
+}
+
+// Scale ranks (and contributions) to sum to 1 (summed in double, as a float
+// sum of many small ranks would itself be off by about the tolerance).
+template <class T>
+void pagerankDynamicNormalizeOmp(vector<T>& r, vector<T>& c, int S) {
+  double s = 0;
+  #pragma omp parallel for schedule(static,4096) reduction(+:s)
+  for (int v=0; v<S; v++)
+    s += r[v];
+  if (s==0) return;
+  #pragma omp parallel for schedule(static,4096)
+  for (int v=0; v<S; v++) {
+    r[v] = T(r[v] / s);
+    c[v] = T(c[v] / s);
+  }
+}
+
+// Iterate on the frontier with a fixed teleport contribution (c0). The rank
+// sum then only settles at the rate of damping, so once the frontier has
+// grown to most vertices, normalize ranks and sweep all (with c0 from the
+// dead-end rank of each iteration) instead.
+template <class T, class G, class H>
+int pagerankDynamicOmpLoop(vector<T>& a, vector<T>& r, vector<T>& c, const vector<T>& f, vector<char>& vaff, vector<char>& vchg, const G& x, const H& xt, size_t naff, int S, int N, T c0, T p, T E, T F, int L) {
+  int  l = 0;
+  bool all = false;
+  T e0 = T();
+  for (; l<L; l++) {
+    if (all) c0 = (1-p)/N + p*pagerankDynamicDeadOmp(r, xt, S)/N;
+    T e1 = pagerankDynamicOmpOnce(a, r, c, vaff, vchg, xt, S, c0, F);
+    pagerankDynamicCommitOmp(r, c, a, f, vaff, S);
+    if (e1 < E || e1 == e0) break;
+    e0 = e1;
+    if (all) continue;
+    naff += pagerankDynamicExpandOmp(vaff, vchg, x, S);
+    if (naff <= size_t(N)/4) continue;
+    pagerankDynamicAffectAllOmp(vaff, xt, S);
+    pagerankDynamicNormalizeOmp(r, c, S);
+    all = true; e0 = T();
+  }
+  if (!all) pagerankDynamicNormalizeOmp(r, c, S);
+  return l;
+}
+
+template <class T, class G, class H>
+int pagerankDynamicOmpCore(vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, vector<char>& vaff, vector<char>& vchg, const G& x, const H& xt, const vector<pair<int, int>>& deletions, const vector<pair<int, int>>& insertions, int S, int N, const vector<T>& q, T p, T E, T F, int L) {
+  T c0 = pagerankDynamicTeleportBefore(q, xt, deletions, insertions, p);
+  fillOmp(vaff, char());
+  pagerankDynamicAffected(vaff, x, deletions, insertions);
+  pagerankDynamicInitOmp(r, vaff, q, xt, S, c0);
+  pagerankDynamicFactorOmp(f, xt, S, p);
+  multiplyOmp(c, r, f);
+  size_t naff = count(vaff, char(1));
+  return pagerankDynamicOmpLoop(a, r, c, f, vaff, vchg, x, xt, naff, S, N, c0, p, E, F, L);
+}
+
+
+// Find pagerank of an updated graph, from ranks of the graph before the update.
+// Only vertices reachable from updated edges (the frontier) are recomputed,
+// with the teleport contribution of the previous ranks; ranks are then scaled
+// to sum to 1, which takes up any change in dead-end rank. If the frontier grows
+// to most vertices, all are swept as in a static pagerank.
+// Ranks are kept by vertex id (not index), as the graph changes between calls.
+// @param x original graph (after update)
+// @param xt transpose graph, with vertex-data=out-degree (after update)
+// @param deletions edges u->v removed in the update
+// @param insertions edges u->v added in the update
+// @param q ranks before the update (by vertex id)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500, frontierTolerance=1e-6}
+// @returns {ranks, iterations, time}
+template <class G, class H, class T=float>
+PagerankResult<T> pagerankDynamicOmp(const G& x, const H& xt, const vector<pair<int, int>>& deletions, const vector<pair<int, int>>& insertions, const vector<T>& q, PagerankOptions<T> o={}) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  T    F = o.frontierTolerance;
+  int  L = o.maxIterations, l;
+  int  S = xt.span();
+  int  N = xt.order();
+  vector<T> a(S), r(S), f(S), c(S);
+  vector<char> vaff(S), vchg(S);
+  float t = measureDuration([&]() { l = pagerankDynamicOmpCore(a, r, f, c, vaff, vchg, x, xt, deletions, insertions, S, N, q, p, E, F, L); }, o.repeat);
+  return {r, l, t};
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "edges.hxx"
+#include "pagerank.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+using std::swap;
+
+
+
+
+// Vector gathers do not pay off for short in-edge lists.
+#ifndef SIMD_MIN
+#define SIMD_MIN 32
+#endif
+
+
+// Per-thread partial sums (padded to avoid false sharing).
+template <class T>
+struct alignas(64) PagerankPartial {
+  T dead;   // sum of dead-end ranks
+  T error;  // sum of absolute rank change
+};
+
+
+// Split vertices among threads, with an equal share of (vertex + in-edge) work.
+// @param ps (output) vertex range of each thread [0, TH]
+template <class J>
+void pagerankPartition(vector<int>& ps, const J& vfrom, int N, int TH) {
+  long W = long(vfrom[N]) + N;
+  ps.resize(TH+1);
+  for (int t=0; t<=TH; t++) {
+    long w = W*t/TH;
+    int  v = 0, V = N;
+    while (v<V) {
+      int m = (v+V)/2;
+      if (long(vfrom[m]) + m < w) v = m+1;
+      else V = m;
+    }
+    ps[t] = v;
+  }
+}
+
+
+// Whole loop runs in one parallel region, each thread owning a vertex range.
+// Teleport, contribution, gather, and error are fused in one pass, with
+// per-thread partials double-buffered so that one barrier per iteration suffices.
+// Vertex ranges are split once the team is formed, as it may have fewer threads
+// than requested (dynamic adjustment, nesting, or a thread limit).
+template <class T, class J>
+int pagerankFusedOmpLoop(vector<T>& a, vector<T>& r, vector<T>& c, vector<T>& d, const vector<T>& f, const J& vfrom, const J& efrom, const J& vdata, vector<int>& ps, vector<PagerankPartial<T>>& ws, int N, T p, T E, int L, vector<float> *ts=nullptr) {
+  int l = 0;
+  const int *eb = efrom.data();
+  #pragma omp parallel
+  {
+    int TH = omp_get_num_threads();
+    #pragma omp single
+    {
+      pagerankPartition(ps, vfrom, N, TH);
+      ws.resize(2*TH);
+    }
+    int t = omp_get_thread_num();
+    int i = ps[t], I = ps[t+1], k = 0;
+    T *ra = r.data(), *aa = a.data(), *ca = c.data(), *da = d.data();
+    T s = T(), e0 = T();
+    for (int v=i; v<I; v++) {
+      ca[v] = ra[v] * f[v];
+      if (vdata[v]==0) s += ra[v];
+    }
+    ws[t].dead = s;
+    #pragma omp barrier
+    auto t0 = timeNow();
+    for (; k<L; k++) {
+      const PagerankPartial<T> *wr = ws.data() + (k&1)*TH;
+      PagerankPartial<T>       *ww = ws.data() + ((k+1)&1)*TH;
+      T sd = T();
+      for (int u=0; u<TH; u++)
+        sd += wr[u].dead;
+      T c0 = (1-p)/N + p*sd/N;
+      T s = T(), e = T();
+      for (int v=i; v<I; v++) {
+        int j = vfrom[v], D = vfrom[v+1] - j;
+        T rv = c0 + (D<SIMD_MIN? sumAt(ca, eb+j, D) : sumAtSimd(ca, eb+j, D));
+        aa[v] = rv;
+        da[v] = rv * f[v];
+        if (vdata[v]==0) s += rv;
+        e += abs(rv - ra[v]);
+      }
+      ww[t].dead  = s;
+      ww[t].error = e;
+      #pragma omp barrier
+      if (ts && t==0) { auto t1 = timeNow(); ts->push_back(duration(t0, t1)); t0 = t1; }
+      T e1 = T();
+      for (int u=0; u<TH; u++)
+        e1 += ww[u].error;
+      if (e1 < E || e1 == e0) break;
+      swap(aa, ra);
+      swap(ca, da);
+      e0 = e1;
+    }
+    if (t==0) l = k;
+  }
+  if (l & 1) swap(a, r);
+  return l;
+}
+
+template <class T, class J>
+int pagerankFusedOmpCore(vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, vector<T>& d, const J& vfrom, const J& efrom, const J& vdata, vector<int>& ps, vector<PagerankPartial<T>>& ws, int N, const vector<T> *q, T p, T E, int L, float *ti=nullptr, vector<float> *ts=nullptr) {
+  auto t0 = timeNow();
+  if (q) copyOmp(r, *q);
+  else fillOmp(r, T(1)/N);
+  pagerankFactorOmp(f, vfrom, efrom, vdata, N, p);
+  if (ti) *ti = duration(t0, timeNow());
+  if (ts) ts->clear();
+  return pagerankFusedOmpLoop(a, r, c, d, f, vfrom, efrom, vdata, ps, ws, N, p, E, L, ts);
+}
+
+
+// Find pagerank accelerated using OpenMP, with a fused edge-balanced kernel.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param q initial ranks (optional)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @returns {ranks, iterations, time, initializationTime, iterationTimes}
+template <class G, class T=float>
+PagerankResult<T> pagerankFusedOmp(const G& xt, const vector<T> *q=nullptr, PagerankOptions<T> o={}) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  int  L = o.maxIterations, l;
+  const auto& vfrom = sourceOffsets(xt);
+  const auto& efrom = destinationIndices(xt);
+  const auto& vdata = vertexData(xt);
+  int  N = xt.order();
+  vector<T> a(N), r(N), f(N), c(N), d(N);
+  vector<int> ps;
+  vector<PagerankPartial<T>> ws;
+  float ti = 0; vector<float> ts;
+  float t = measureDuration([&]() { l = pagerankFusedOmpCore(a, r, f, c, d, vfrom, efrom, vdata, ps, ws, N, q, p, E, L, &ti, &ts); }, o.repeat);
+  PagerankResult<T> b(vertexContainer(xt, a), l, t);
+  b.initializationTime = ti;
+  b.iterationTimes     = move(ts);
+  return b;
+}
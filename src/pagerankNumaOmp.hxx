@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <sched.h>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "DiGraphCsr.hxx"
+#include "numa.hxx"
+#include "pagerank.hxx"
+#include "pagerankOmp.hxx"
+
+using std::vector;
+
+
+
+
+// Build CSR arrays of a graph in parallel, with each part first touched by
+// the thread that reads it in pagerankOmpOnce() (static partition of 4096).
+template <class G>
+void pagerankNumaCsrOmp(DefaultInitVector<int>& vfrom, DefaultInitVector<int>& efrom, DefaultInitVector<int>& vdata, const G& xt) {
+  auto ks   = vertices(xt);
+  auto vidx = vertexIndicesOmp(ks, xt.span());
+  int  N = ks.size();
+  vector<int> deg(N);
+  vfrom.resize(N+1);
+  vdata.resize(N);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<N; i++) {
+    deg[i]   = xt.degree(ks[i]);
+    vfrom[i] = 0;
+    vdata[i] = xt.vertexData(ks[i]);
+  }
+  vfrom[N] = exclusiveScanOmp(vfrom.data(), deg.data(), N);
+  efrom.resize(vfrom[N]);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<N; i++) {
+    int j = vfrom[i];
+    for (int v : xt.edges(ks[i]))
+      efrom[j++] = vidx[v];
+  }
+}
+
+
+// Find pagerank accelerated using OpenMP, with NUMA-aware memory placement.
+// Rank, factor, contribution, and CSR arrays are allocated without
+// initialization, and first touched with the static partition used by the
+// kernels, so that each thread mostly reads pages on its own node.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param q initial ranks (optional)
+// @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
+// @param k pin threads to CPUs (none, compact, scatter across nodes)
+// @param pl (output) node placement of each array (optional)
+// @returns {ranks, iterations, time, preprocessingTime, initializationTime, iterationTimes}
+template <class G, class T=float>
+PagerankResult<T> pagerankNumaOmp(const G& xt, const vector<T> *q=nullptr, PagerankOptions<T> o={}, ThreadPinning k=PIN_NONE, NumaPlacement *pl=nullptr) {
+  T    p = o.damping;
+  T    E = o.tolerance;
+  int  L = o.maxIterations, l;
+  int  N = xt.order();
+  auto ms = pinThreadsOmp(k);
+  DefaultInitVector<int> vfrom, efrom, vdata;
+  DefaultInitVector<T>   a, r, f, c;
+  float tp = measureDuration([&]() {
+    pagerankNumaCsrOmp(vfrom, efrom, vdata, xt);
+    a.resize(N); r.resize(N); f.resize(N); c.resize(N);
+    fillOmp(a, T()); fillOmp(r, T()); fillOmp(f, T()); fillOmp(c, T());
+  });
+  float ti = 0; vector<float> ts;
+  float t = measureDuration([&]() { l = pagerankOmpCore(a, r, f, c, vfrom, efrom, vdata, N, q, p, E, L, &ti, &ts); }, o.repeat);
+  if (pl) {
+    numaPlacement(*pl, "sourceOffsets", vfrom);
+    numaPlacement(*pl, "destinationIndices", efrom);
+    numaPlacement(*pl, "vertexData", vdata);
+    numaPlacement(*pl, "ranks", a);
+    numaPlacement(*pl, "factors", f);
+    numaPlacement(*pl, "contributions", c);
+  }
+  unpinThreadsOmp(k, ms);
+  vector<T> s(N);
+  copyOmp(s, a);
+  PagerankResult<T> b(vertexContainer(xt, s), l, t, tp);
+  b.initializationTime = ti;
+  b.iterationTimes     = move(ts);
+  return b;
+}
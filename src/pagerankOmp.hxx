@@ -6,12 +6,13 @@
 #include "pagerank.hxx"
 
 using std::swap;
+using std::move;
 
 
 
 
-template <class T>
-T pagerankTeleportOmp(const vector<T>& r, const vector<int>& vfrom, const vector<int>& efrom, const vector<int>& vdata, int N, T p) {
+template <class T, class A, class J>
+T pagerankTeleportOmp(const vector<T, A>& r, const J& vfrom, const J& efrom, const J& vdata, int N, T p) {
   T a = (1-p)/N;
   #pragma omp parallel for schedule(static,4096) reduction(+:a)
   for (int u=0; u<N; u++)
@@ -19,8 +20,8 @@ T pagerankTeleportOmp(const vector<T>& r, const vector<int>& vfrom, const vector
   return a;
 }
 
-template <class T>
-void pagerankFactorOmp(vector<T>& a, const vector<int>& vfrom, const vector<int>& efrom, const vector<int>& vdata, int N, T p) {
+template <class T, class A, class J>
+void pagerankFactorOmp(vector<T, A>& a, const J& vfrom, const J& efrom, const J& vdata, int N, T p) {
   #pragma omp parallel for schedule(static,4096)
   for (int u=0; u<N; u++) {
     int d = vdata[u];
@@ -28,22 +29,24 @@ void pagerankFactorOmp(vector<T>& a, const vector<int>& vfrom, const vector<int>
   }
 }
 
-template <class T>
-void pagerankOmpOnce(vector<T>& a, const vector<T>& c, const vector<int>& vfrom, const vector<int>& efrom, const vector<int>& vdata, int N, T c0) {
+template <class T, class A, class J>
+void pagerankOmpOnce(vector<T, A>& a, const vector<T, A>& c, const J& vfrom, const J& efrom, const J& vdata, int N, T c0) {
   #pragma omp parallel for schedule(static,4096)
   for (int v=0; v<N; v++)
     a[v] = c0 + sumAt(c, slice(efrom, vfrom[v], vfrom[v+1]));
 }
 
-template <class T>
-int pagerankOmpLoop(vector<T>& a, vector<T>& r, const vector<T>& f, vector<T>& c, const vector<int>& vfrom, const vector<int>& efrom, const vector<int>& vdata, int N, T p, T E, int L) {
+template <class T, class A, class J>
+int pagerankOmpLoop(vector<T, A>& a, vector<T, A>& r, const vector<T, A>& f, vector<T, A>& c, const J& vfrom, const J& efrom, const J& vdata, int N, T p, T E, int L, vector<float> *ts=nullptr) {
   int l = 0;
   T e0 = T();
+  auto t0 = timeNow();
   for (; l<L; l++) {
     T c0 = pagerankTeleportOmp(r, vfrom, efrom, vdata, N, p);
     multiplyOmp(c, r, f);
     pagerankOmpOnce(a, c, vfrom, efrom, vdata, N, c0);
     T e1 = absErrorOmp(a, r);
+    if (ts) { auto t1 = timeNow(); ts->push_back(duration(t0, t1)); t0 = t1; }
     if (e1 < E || e1 == e0) break;
     swap(a, r);
     e0 = e1;
@@ -51,12 +54,15 @@ int pagerankOmpLoop(vector<T>& a, vector<T>& r, const vector<T>& f, vector<T>& c
   return l;
 }
 
-template <class T>
-int pagerankOmpCore(vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, const vector<int>& vfrom, const vector<int>& efrom, const vector<int>& vdata, int N, const vector<T> *q, T p, T E, int L) {
+template <class T, class A, class J>
+int pagerankOmpCore(vector<T, A>& a, vector<T, A>& r, vector<T, A>& f, vector<T, A>& c, const J& vfrom, const J& efrom, const J& vdata, int N, const vector<T> *q, T p, T E, int L, float *ti=nullptr, vector<float> *ts=nullptr) {
+  auto t0 = timeNow();
   if (q) copyOmp(r, *q);
   else fillOmp(r, T(1)/N);
   pagerankFactorOmp(f, vfrom, efrom, vdata, N, p);
-  return pagerankOmpLoop(a, r, f, c, vfrom, efrom, vdata, N, p, E, L);
+  if (ti) *ti = duration(t0, timeNow());
+  if (ts) ts->clear();
+  return pagerankOmpLoop(a, r, f, c, vfrom, efrom, vdata, N, p, E, L, ts);
 }
 
 
@@ -64,17 +70,21 @@ int pagerankOmpCore(vector<T>& a, vector<T>& r, vector<T>& f, vector<T>& c, cons
 // @param xt transpose graph, with vertex-data=out-degree
 // @param q initial ranks (optional)
 // @param o options {damping=0.85, tolerance=1e-6, maxIterations=500}
-// @returns {ranks, iterations, time}
+// @returns {ranks, iterations, time, initializationTime, iterationTimes}
 template <class G, class T=float>
 PagerankResult<T> pagerankOmp(const G& xt, const vector<T> *q=nullptr, PagerankOptions<T> o={}) {
   T    p = o.damping;
   T    E = o.tolerance;
   int  L = o.maxIterations, l;
-  auto vfrom = sourceOffsets(xt);
-  auto efrom = destinationIndices(xt);
-  auto vdata = vertexData(xt);
-  int  N     = xt.order();
+  const auto& vfrom = sourceOffsets(xt);
+  const auto& efrom = destinationIndices(xt);
+  const auto& vdata = vertexData(xt);
+  int  N = xt.order();
   vector<T> a(N), r(N), f(N), c(N);
-  float t = measureDuration([&]() { l = pagerankOmpCore(a, r, f, c, vfrom, efrom, vdata, N, q, p, E, L); }, o.repeat);
-  return {vertexContainer(xt, a), l, t};
+  float ti = 0; vector<float> ts;
+  float t = measureDuration([&]() { l = pagerankOmpCore(a, r, f, c, vfrom, efrom, vdata, N, q, p, E, L, &ti, &ts); }, o.repeat);
+  PagerankResult<T> b(vertexContainer(xt, a), l, t);
+  b.initializationTime = ti;
+  b.iterationTimes     = move(ts);
+  return b;
 }
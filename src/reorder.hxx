@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "transpose.hxx"
+
+using std::vector;
+using std::stable_sort;
+using std::reverse;
+using std::sort;
+
+
+
+
+// VERTEX-ORDER
+// ------------
+// Orderings that improve locality of rank gathers, on CSR arrays of a
+// transpose graph (vertex-data=out-degree). Each returns the old index
+// of every new index.
+
+enum VertexOrder {
+  ORDER_NONE,
+  ORDER_DEGREE,      // by out-degree, descending
+  ORDER_RCM,         // reverse Cuthill-McKee, on the undirected graph
+  ORDER_HUB_CLUSTER  // hubs (above average out-degree) first, each group in input order
+};
+
+
+inline const char* vertexOrderName(VertexOrder k) {
+  switch (k) {
+    default:                return "none";
+    case ORDER_DEGREE:      return "degree";
+    case ORDER_RCM:         return "rcm";
+    case ORDER_HUB_CLUSTER: return "hub-cluster";
+  }
+}
+
+
+template <class J>
+auto degreeOrder(const J& vdata, int N) {
+  vector<int> a(N);
+  for (int i=0; i<N; i++)
+    a[i] = i;
+  stable_sort(a.begin(), a.end(), [&](int u, int v) { return vdata[u] > vdata[v]; });
+  return a;
+}
+
+
+template <class J>
+auto hubClusterOrder(const J& vdata, int N) {
+  vector<int> a;
+  a.reserve(N);
+  double avg = 0;
+  for (int u=0; u<N; u++)
+    avg += vdata[u];
+  avg /= N>0? N : 1;
+  for (int u=0; u<N; u++)
+    if (vdata[u] >  avg) a.push_back(u);
+  for (int u=0; u<N; u++)
+    if (vdata[u] <= avg) a.push_back(u);
+  return a;
+}
+
+
+template <class J>
+auto rcmOrder(const J& vfrom, const J& efrom, int N) {
+  vector<int> ofrom, oto; vector<NONE> odata;
+  transposeCsrOmp(ofrom, oto, odata, vfrom, efrom, vector<NONE>(vfrom[N]));
+  auto deg = [&](int u) { return vfrom[u+1]-vfrom[u] + ofrom[u+1]-ofrom[u]; };
+  vector<int> us(N), a;
+  vector<char> vis(N);
+  for (int u=0; u<N; u++)
+    us[u] = u;
+  stable_sort(us.begin(), us.end(), [&](int u, int v) { return deg(u) < deg(v); });
+  a.reserve(N);
+  for (int s : us) {
+    if (vis[s]) continue;
+    vis[s] = 1;
+    a.push_back(s);
+    // breadth-first, visiting unvisited neighbours by increasing degree
+    for (size_t i=a.size()-1; i<a.size(); i++) {
+      int u = a[i]; size_t j = a.size();
+      for (int k=vfrom[u]; k<vfrom[u+1]; k++)
+        if (!vis[efrom[k]]) { vis[efrom[k]] = 1; a.push_back(efrom[k]); }
+      for (int k=ofrom[u]; k<ofrom[u+1]; k++)
+        if (!vis[oto[k]]) { vis[oto[k]] = 1; a.push_back(oto[k]); }
+      stable_sort(a.begin()+j, a.end(), [&](int u, int v) { return deg(u) < deg(v); });
+    }
+  }
+  reverse(a.begin(), a.end());
+  return a;
+}
+
+
+template <class J>
+auto vertexOrder(const J& vfrom, const J& efrom, const J& vdata, int N, VertexOrder k) {
+  switch (k) {
+    default: {
+      vector<int> a(N);
+      for (int i=0; i<N; i++)
+        a[i] = i;
+      return a;
+    }
+    case ORDER_DEGREE:      return degreeOrder(vdata, N);
+    case ORDER_RCM:         return rcmOrder(vfrom, efrom, N);
+    case ORDER_HUB_CLUSTER: return hubClusterOrder(vdata, N);
+  }
+}
+
+
+
+
+// RELABEL-CSR
+// -----------
+
+// Relabel CSR arrays of a graph with a vertex order.
+// @param afrom (output) source offsets
+// @param ato (output) destination indices (sorted per vertex)
+// @param adata (output) vertex data
+// @param ks old index of each new index
+template <class J>
+void relabelCsrOmp(vector<int>& afrom, vector<int>& ato, vector<int>& adata, const vector<int>& ks, const J& vfrom, const J& efrom, const J& vdata) {
+  int N = ks.size();
+  vector<int> inv(N), deg(N);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<N; i++) {
+    int u = ks[i];
+    inv[u] = i;
+    deg[i] = vfrom[u+1] - vfrom[u];
+  }
+  afrom.resize(N+1);
+  afrom[N] = exclusiveScanOmp(afrom.data(), deg.data(), N);
+  ato.resize(afrom[N]);
+  adata.resize(N);
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int i=0; i<N; i++) {
+    int u = ks[i], j = afrom[i];
+    for (int k=vfrom[u]; k<vfrom[u+1]; k++)
+      ato[j++] = inv[efrom[k]];
+    sort(ato.begin()+afrom[i], ato.begin()+j);
+    adata[i] = vdata[u];
+  }
+}
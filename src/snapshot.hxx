@@ -0,0 +1,355 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "edges.hxx"
+#include "transpose.hxx"
+#include "mtx.hxx"
+
+using std::string;
+using std::vector;
+using std::swap;
+using std::move;
+
+
+
+
+// SNAPSHOT-HEADER
+// ---------------
+// Binary snapshot of a transposed graph, with vertex-data=out-degree.
+// Layout: header, vertex keys, vertex indices, source offsets,
+// destination indices, vertex data (each array 64-byte aligned).
+
+#define SNAPSHOT_MAGIC   "PRSNAP\0"
+#define SNAPSHOT_VERSION 1
+
+struct SnapshotHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  int64_t  span;
+  int64_t  order;
+  int64_t  size;
+  int64_t  sourceSize;  // size of source file, for staleness check
+  int64_t  sourceTime;  // mtime (ns) of source file, for staleness check
+  uint64_t checksum;    // of everything after the header
+};
+
+
+inline size_t snapshotAlign(size_t i) {
+  return (i + 63) & ~size_t(63);
+}
+
+// Byte offsets of each array, and total file size.
+inline void snapshotLayout(size_t *os, int64_t S, int64_t N, int64_t M) {
+  os[0] = snapshotAlign(sizeof(SnapshotHeader));
+  os[1] = snapshotAlign(os[0] + N*sizeof(int));
+  os[2] = snapshotAlign(os[1] + S*sizeof(int));
+  os[3] = snapshotAlign(os[2] + (N+1)*sizeof(int));
+  os[4] = snapshotAlign(os[3] + M*sizeof(int));
+  os[5] = snapshotAlign(os[4] + N*sizeof(int));
+}
+
+
+// Checksum of a byte buffer (hashed in 1MB blocks, in parallel).
+inline uint64_t snapshotChecksum(const char *x, size_t N) {
+  const uint64_t P = 1099511628211ULL;
+  const size_t   B = 1 << 20;
+  size_t NB = ceilDiv(N, B);
+  vector<uint64_t> hs(NB);
+  #pragma omp parallel for schedule(dynamic,1)
+  for (size_t b=0; b<NB; b++) {
+    size_t i = b*B, I = min(i+B, N);
+    uint64_t h = 14695981039346656037ULL, w;
+    for (; i+8<=I; i+=8) {
+      memcpy(&w, x+i, 8);
+      h = (h ^ w) * P;
+    }
+    for (; i<I; i++)
+      h = (h ^ uint8_t(x[i])) * P;
+    hs[b] = h;
+  }
+  uint64_t a = 14695981039346656037ULL;
+  for (uint64_t h : hs)
+    a = (a ^ h) * P;
+  return a;
+}
+
+
+// Size and mtime (ns) of a file (false if missing).
+inline bool fileStat(int64_t& size, int64_t& time, const char *pth) {
+  struct stat st;
+  if (stat(pth, &st)!=0) return false;
+  size = st.st_size;
+  time = int64_t(st.st_mtim.tv_sec)*1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+
+
+
+// DI-GRAPH-SNAPSHOT
+// -----------------
+// Read-only transposed graph, memory-mapped from a snapshot file.
+
+class DiGraphSnapshot {
+  public:
+  using TVertex = int;
+  using TEdge   = NONE;
+
+  private:
+  void  *ptr = nullptr;
+  size_t len = 0;
+  bool   mapped = false;
+  vector<char> own;  // used instead of a mapping, when adopting a buffer
+  const SnapshotHeader *hdr = nullptr;
+  Span<const int> vkeys, vidx, vfrom, efrom, vdata;
+
+  // Cute helpers
+  private:
+  int s() const { return vidx.size(); }
+  template <class T>
+  Span<const T> at(size_t o, size_t N) const { return Span<const T>((const T*) ((const char*) ptr + o), N); }
+
+  // Read operations
+  public:
+  int span()  const { return s(); }
+  int order() const { return vkeys.size(); }
+  int size()  const { return efrom.size(); }
+  const SnapshotHeader& header() const { return *hdr; }
+
+  bool hasVertex(int u) const { return u >= 0 && u < s() && vidx[u] >= 0; }
+  auto edges(int u) const {
+    int i = hasVertex(u)? vidx[u] : -1;
+    int b = i<0? 0 : vfrom[i], e = i<0? 0 : vfrom[i+1];
+    return transform(slice(efrom, b, e), [this](int j) { return vkeys[j]; });
+  }
+  int degree(int u)   const { return hasVertex(u)? vfrom[vidx[u]+1] - vfrom[vidx[u]] : 0; }
+  auto vertices()     const { return iterable(vkeys); }
+  int vertexData(int u) const { return hasVertex(u)? vdata[vidx[u]] : 0; }
+
+  // CSR arrays
+  public:
+  Span<const int> vertexKeys()         const { return vkeys; }
+  Span<const int> vertexIndices()      const { return vidx; }
+  Span<const int> sourceOffsets()      const { return vfrom; }
+  Span<const int> destinationIndices() const { return efrom; }
+  Span<const int> vertexValues()       const { return vdata; }
+
+  // Generate operations
+  public:
+  template <class T>
+  auto vertexContainer(T _) const { return vector<T>(s()); }
+
+  // Map/unmap operations
+  private:
+  // Validate header, and locate arrays (false if truncated, or of another version).
+  bool attach(bool verify) {
+    if (len < sizeof(SnapshotHeader)) { unmap(); return false; }
+    hdr = (const SnapshotHeader*) ptr;
+    size_t os[6];
+    snapshotLayout(os, hdr->span, hdr->order, hdr->size);
+    bool ok = memcmp(hdr->magic, SNAPSHOT_MAGIC, 8)==0 && hdr->version==SNAPSHOT_VERSION;
+    ok = ok && hdr->headerSize==sizeof(SnapshotHeader) && os[5]==len;
+    ok = ok && (!verify || snapshotChecksum((const char*) ptr + os[0], len - os[0])==hdr->checksum);
+    if (!ok) { unmap(); return false; }
+    vkeys = at<int>(os[0], hdr->order);
+    vidx  = at<int>(os[1], hdr->span);
+    vfrom = at<int>(os[2], hdr->order+1);
+    efrom = at<int>(os[3], hdr->size);
+    vdata = at<int>(os[4], hdr->order);
+    if (!validate()) { unmap(); return false; }
+    return true;
+  }
+
+  // Check that arrays are consistent, so that no kernel reads out of bounds.
+  bool validate() const {
+    int S = vidx.size(), N = vkeys.size(), M = efrom.size(), bad = 0;
+    if (S<0 || N<0 || M<0 || vfrom[0]!=0 || vfrom[N]!=M) return false;
+    #pragma omp parallel for schedule(static,4096) reduction(+:bad)
+    for (int i=0; i<N; i++) {
+      int u = vkeys[i];
+      if (vfrom[i]>vfrom[i+1] || vdata[i]<0 || u<0 || u>=S || vidx[u]!=i) ++bad;
+    }
+    #pragma omp parallel for schedule(static,4096) reduction(+:bad)
+    for (int i=0; i<M; i++)
+      if (efrom[i]<0 || efrom[i]>=N) ++bad;
+    return bad==0;
+  }
+
+  public:
+  // Map a snapshot file (false if missing or invalid).
+  bool map(const char *pth, bool verify=true) {
+    unmap();
+    int fd = open(pth, O_RDONLY);
+    if (fd<0) return false;
+    struct stat st;
+    if (fstat(fd, &st)!=0 || st.st_size==0) { close(fd); return false; }
+    len = st.st_size;
+    ptr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr==MAP_FAILED) { ptr = nullptr; len = 0; return false; }
+    mapped = true;
+    return attach(verify);
+  }
+
+  // Use an in-memory snapshot buffer (false if invalid).
+  bool adopt(vector<char>&& buf) {
+    unmap();
+    own = move(buf);
+    ptr = own.data();
+    len = own.size();
+    return attach(false);
+  }
+
+  void unmap() {
+    if (mapped) munmap(ptr, len);
+    own.clear(); own.shrink_to_fit();
+    ptr = nullptr; len = 0; mapped = false; hdr = nullptr;
+    vkeys = vidx = vfrom = efrom = vdata = Span<const int>();
+  }
+
+  // Constructors
+  public:
+  DiGraphSnapshot() {}
+  DiGraphSnapshot(const DiGraphSnapshot&) = delete;
+  DiGraphSnapshot& operator=(const DiGraphSnapshot&) = delete;
+  DiGraphSnapshot(DiGraphSnapshot&& x) { *this = move(x); }
+  DiGraphSnapshot& operator=(DiGraphSnapshot&& x) {
+    swap(ptr, x.ptr); swap(len, x.len); swap(mapped, x.mapped);
+    swap(own, x.own); swap(hdr, x.hdr);
+    swap(vkeys, x.vkeys); swap(vidx, x.vidx); swap(vfrom, x.vfrom);
+    swap(efrom, x.efrom); swap(vdata, x.vdata);
+    return *this;
+  }
+  ~DiGraphSnapshot() { unmap(); }
+};
+
+
+
+
+// CSR-ARRAYS
+// ----------
+
+inline Span<const int> sourceOffsets(const DiGraphSnapshot& x) {
+  return x.sourceOffsets();
+}
+
+inline Span<const int> destinationIndices(const DiGraphSnapshot& x) {
+  return x.destinationIndices();
+}
+
+inline Span<const int> vertexData(const DiGraphSnapshot& x) {
+  return x.vertexValues();
+}
+
+
+
+
+// WRITE-SNAPSHOT
+// --------------
+
+// Build a snapshot of a transposed graph, with vertex-data=out-degree.
+// @param xt transpose graph, with vertex-data=out-degree
+// @param sourceSize size of source file (for staleness check)
+// @param sourceTime mtime (ns) of source file (for staleness check)
+// @returns snapshot file contents
+template <class G>
+vector<char> snapshotBuffer(const G& xt, int64_t sourceSize=0, int64_t sourceTime=0) {
+  const auto& vfrom = sourceOffsets(xt);
+  const auto& efrom = destinationIndices(xt);
+  const auto& vdata = vertexData(xt);
+  auto vkeys = vertices(xt);
+  auto vidx  = vertexIndicesOmp(vkeys, xt.span());
+  int64_t S = xt.span(), N = xt.order(), M = xt.size();
+  size_t os[6];
+  snapshotLayout(os, S, N, M);
+  vector<char> a(os[5]);
+  memcpy(&a[os[0]], vkeys.data(), N*sizeof(int));
+  memcpy(&a[os[1]], vidx.data(),  S*sizeof(int));
+  memcpy(&a[os[2]], vfrom.data(), (N+1)*sizeof(int));
+  memcpy(&a[os[3]], efrom.data(), M*sizeof(int));
+  memcpy(&a[os[4]], vdata.data(), N*sizeof(int));
+  SnapshotHeader h = {};
+  memcpy(h.magic, SNAPSHOT_MAGIC, 8);
+  h.version    = SNAPSHOT_VERSION;
+  h.headerSize = sizeof(SnapshotHeader);
+  h.span  = S;
+  h.order = N;
+  h.size  = M;
+  h.sourceSize = sourceSize;
+  h.sourceTime = sourceTime;
+  h.checksum   = snapshotChecksum(a.data() + os[0], a.size() - os[0]);
+  memcpy(&a[0], &h, sizeof(h));
+  return a;
+}
+
+
+// Write snapshot file contents (via a unique temporary file, so that
+// concurrent writers do not clobber each other).
+// @returns false if the file could not be written
+inline bool writeSnapshot(const char *pth, const vector<char>& buf) {
+  string tmp = string(pth) + ".XXXXXX";
+  int fd = mkstemp(&tmp[0]);
+  if (fd<0) return false;
+  bool ok = fchmod(fd, 0644)==0;
+  for (size_t i=0; ok && i<buf.size();) {
+    ssize_t n = ::write(fd, buf.data()+i, buf.size()-i);
+    if (n<0 && errno==EINTR) continue;
+    ok = n>0; i += ok? n : 0;
+  }
+  ok = close(fd)==0 && ok;
+  if (ok && rename(tmp.c_str(), pth)==0) return true;
+  remove(tmp.c_str());
+  return false;
+}
+
+template <class G>
+bool writeSnapshot(const char *pth, const G& xt, int64_t sourceSize=0, int64_t sourceTime=0) {
+  return writeSnapshot(pth, snapshotBuffer(xt, sourceSize, sourceTime));
+}
+
+
+
+
+// READ-SNAPSHOT
+// -------------
+
+// Map a snapshot file.
+// @param a (output) mapped graph
+// @param pth path to snapshot file
+// @param verify verify checksum?
+// @returns false if missing or invalid
+inline bool readSnapshot(DiGraphSnapshot& a, const char *pth, bool verify=true) {
+  return a.map(pth, verify);
+}
+
+
+// Map a snapshot of an mtx file, rebuilding it if missing or stale.
+// Falls back to an in-memory snapshot, if the file cannot be written.
+// @param pth path to mtx file
+// @param snap path to snapshot file
+// @param verify verify checksum of an existing snapshot?
+// @returns transposed graph, with vertex-data=out-degree
+inline DiGraphSnapshot readSnapshotOrMtx(const char *pth, const char *snap, bool verify=true) {
+  DiGraphSnapshot a;
+  int64_t size = 0, time = 0;
+  fileStat(size, time, pth);
+  if (a.map(snap, verify) && a.header().sourceSize==size && a.header().sourceTime==time) return a;
+  auto buf = snapshotBuffer(transposeWithDegree(readMtxCsr(pth)), size, time);
+  if (writeSnapshot(snap, buf) && a.map(snap, false)) return a;
+  a.adopt(move(buf));
+  return a;
+}
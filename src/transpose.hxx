@@ -1,5 +1,16 @@
 #pragma once
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "_main.hxx"
 #include "DiGraph.hxx"
+#include "DiGraphCsr.hxx"
+
+using std::vector;
+using std::pair;
+using std::move;
+using std::sort;
+using std::is_sorted;
 
 
 
@@ -45,3 +56,81 @@ auto transposeWithDegree(const G& x) {
   DiGraph<int, E> a; transposeWithDegree(a, x);
   return a;
 }
+
+
+
+
+// TRANSPOSE-CSR
+// -------------
+// Transpose CSR arrays with a parallel counting sort on targets.
+
+template <class E, class J, class K>
+void transposeCsrOmp(vector<int>& afrom, vector<int>& ato, vector<E>& adata, const J& vfrom, const J& eto, const K& edata) {
+  int N = vfrom.size()-1, M = eto.size();
+  vector<int> deg(N);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<M; i++) {
+    #pragma omp atomic
+    deg[eto[i]]++;
+  }
+  afrom.resize(N+1);
+  afrom[N] = exclusiveScanOmp(afrom.data(), deg.data(), N);
+  fillOmp(deg, 0);
+  ato.resize(M);
+  adata.resize(M);
+  #pragma omp parallel for schedule(dynamic,2048)
+  for (int u=0; u<N; u++) {
+    for (int i=vfrom[u]; i<vfrom[u+1]; i++) {
+      int v = eto[i], j;
+      #pragma omp atomic capture
+      j = deg[v]++;
+      ato[afrom[v]+j]   = u;
+      adata[afrom[v]+j] = edata[i];
+    }
+  }
+  // restore source order of each target, for deterministic results
+  #pragma omp parallel
+  {
+    vector<pair<int, E>> buf;
+    #pragma omp for schedule(dynamic,2048)
+    for (int v=0; v<N; v++) {
+      int i = afrom[v], I = afrom[v+1];
+      if (is_sorted(ato.begin()+i, ato.begin()+I)) continue;
+      buf.clear();
+      for (int j=i; j<I; j++)
+        buf.push_back({ato[j], adata[j]});
+      sort(buf.begin(), buf.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+      for (int j=i; j<I; j++) {
+        ato[j]   = buf[j-i].first;
+        adata[j] = buf[j-i].second;
+      }
+    }
+  }
+}
+
+
+template <class V, class E>
+auto transpose(const DiGraphCsr<V, E>& x) {
+  auto vkeys = x.vertexKeys();
+  auto vidx  = x.vertexIndices();
+  auto vdata = x.vertexValues();
+  vector<int> vfrom, eto; vector<E> edata;
+  transposeCsrOmp(vfrom, eto, edata, x.sourceOffsets(), x.destinationIndices(), x.edgeValues());
+  return DiGraphCsr<V, E>(move(vkeys), move(vidx), move(vfrom), move(eto), move(vdata), move(edata));
+}
+
+
+template <class V, class E>
+auto transposeWithDegree(const DiGraphCsr<V, E>& x) {
+  auto& xfrom = x.sourceOffsets();
+  int N = x.order();
+  auto vkeys = x.vertexKeys();
+  auto vidx  = x.vertexIndices();
+  vector<int> vdata(N);
+  #pragma omp parallel for schedule(static,4096)
+  for (int i=0; i<N; i++)
+    vdata[i] = xfrom[i+1] - xfrom[i];
+  vector<int> vfrom, eto; vector<E> edata;
+  transposeCsrOmp(vfrom, eto, edata, xfrom, x.destinationIndices(), x.edgeValues());
+  return DiGraphCsr<int, E>(move(vkeys), move(vidx), move(vfrom), move(eto), move(vdata), move(edata));
+}
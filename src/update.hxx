@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <random>
+#include <unordered_set>
+#include "_main.hxx"
+
+using std::vector;
+using std::pair;
+using std::uniform_int_distribution;
+using std::unordered_set;
+
+
+
+
+// EDGE-KEY
+// --------
+
+inline long edgeKey(int u, int v) {
+  return (long(u) << 32) | unsigned(v);
+}
+
+
+
+
+// RANDOM-DELETIONS
+// ----------------
+
+// Pick distinct existing edges at random.
+// @param x original graph
+// @param B number of edges
+// @param rnd random number generator
+// @returns edges u->v
+template <class G, class R>
+auto randomDeletions(const G& x, int B, R& rnd) {
+  vector<pair<int, int>> a;
+  unordered_set<long> es;
+  uniform_int_distribution<int> dis(0, x.span()-1);
+  for (int n=0; n<B*100 && int(a.size())<B; n++) {
+    int u = dis(rnd);
+    int d = x.degree(u);
+    if (d==0) continue;
+    int i = uniform_int_distribution<int>(0, d-1)(rnd), j = 0;
+    for (int v : x.edges(u)) {
+      if (j++!=i) continue;
+      if (es.insert(edgeKey(u, v)).second) a.push_back({u, v});
+      break;
+    }
+  }
+  return a;
+}
+
+
+
+
+// RANDOM-INSERTIONS
+// -----------------
+
+// Pick distinct non-existing edges (between existing vertices) at random.
+// @param x original graph
+// @param B number of edges
+// @param rnd random number generator
+// @returns edges u->v
+template <class G, class R>
+auto randomInsertions(const G& x, int B, R& rnd) {
+  vector<pair<int, int>> a;
+  unordered_set<long> es;
+  uniform_int_distribution<int> dis(0, x.span()-1);
+  for (int n=0; n<B*100 && int(a.size())<B; n++) {
+    int u = dis(rnd), v = dis(rnd);
+    if (!x.hasVertex(u) || !x.hasVertex(v) || x.hasEdge(u, v)) continue;
+    if (es.insert(edgeKey(u, v)).second) a.push_back({u, v});
+  }
+  return a;
+}
+
+
+
+
+// UPDATE-BATCH
+// ------------
+
+// Apply a batch of edge updates to a graph and its transpose.
+// @param x original graph (updated)
+// @param xt transpose graph, with vertex-data=out-degree (updated)
+// @param deletions edges u->v to remove
+// @param insertions edges u->v to add
+template <class G, class H>
+void updateBatch(G& x, H& xt, const vector<pair<int, int>>& deletions, const vector<pair<int, int>>& insertions) {
+  for (auto [u, v] : deletions) {
+    x.removeEdge(u, v);
+    xt.removeEdge(v, u);
+  }
+  for (auto [u, v] : insertions) {
+    x.addEdge(u, v);
+    xt.addVertex(u);
+    xt.addEdge(v, u);
+  }
+  for (auto [u, v] : deletions)
+    xt.setVertexData(u, x.degree(u));
+  for (auto [u, v] : insertions)
+    xt.setVertexData(u, x.degree(u));
+}